@@ -0,0 +1,126 @@
+/*! \file SbArena.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <algorithm>
+
+#include "SbArena.h"
+
+
+SbArena::SbArena(size_t block_size)
+  : block_size_( round_up(block_size) )
+{
+  if ( block_size == 0 )
+    throw std::runtime_error("[SbArena::SbArena] Error: block size must not be 0");
+}
+
+
+
+SbArena::~SbArena()
+{
+  reset();
+}
+
+
+
+void*
+SbArena::allocate(size_t size)
+{
+  size = round_up( size ? size : 1 );
+  for ( FreeList& list: free_ ) {
+    if ( list.size == size && list.first ) {
+      void* memory = list.first;
+      list.first = *static_cast<void**>( memory );
+      return memory;
+    }
+  }
+  // blocks too small for this one are skipped, until the next reset
+  while ( current_ < blocks_.size() && blocks_.at(current_).size - offset_ < size ) {
+    ++current_;
+    offset_ = 0;
+  }
+  if ( current_ == blocks_.size() ) {
+    size_t block_size = std::max( block_size_, size );
+    blocks_.push_back( Block{ std::unique_ptr<uint8_t[]>( new uint8_t[block_size] ), block_size } );
+    offset_ = 0;
+  }
+  void* memory = blocks_.at(current_).data.get() + offset_;
+  offset_ += size;
+  used_ += size;
+  return memory;
+}
+
+
+
+void
+SbArena::deallocate(void* memory, size_t size)
+{
+  if ( !memory )
+    return;
+  size = round_up( size ? size : 1 );
+  for ( FreeList& list: free_ ) {
+    if ( list.size == size ) {
+      *static_cast<void**>( memory ) = list.first;
+      list.first = memory;
+      return;
+    }
+  }
+  *static_cast<void**>( memory ) = nullptr;
+  free_.push_back( FreeList{ size, memory } );
+}
+
+
+
+void
+SbArena::link(Node* node)
+{
+  node->previous = last_;
+  if ( last_ )
+    last_->next = node;
+  last_ = node;
+  ++n_objects_;
+}
+
+
+
+void
+SbArena::unlink(Node* node)
+{
+  if ( node->previous )
+    node->previous->next = node->next;
+  if ( node->next )
+    node->next->previous = node->previous;
+  else
+    last_ = node->previous;
+  --n_objects_;
+}
+
+
+
+void
+SbArena::reset()
+{
+  // destructors may still hand memory back (e.g. shared_ptr control blocks), the free lists are dropped afterwards
+  while ( last_ ) {
+    Node* node = last_;
+    unlink( node );
+    node->destroy( reinterpret_cast<uint8_t*>(node) + node_size );
+  }
+  free_.clear();
+  current_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+
+
+size_t
+SbArena::capacity() const
+{
+  size_t result = 0;
+  for ( const Block& block: blocks_ )
+    result += block.size;
+  return result;
+}
@@ -0,0 +1,152 @@
+/*! \file SbArena.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBARENA_H
+#define SBARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <new>
+
+
+/*! Memory for the objects of one level, handed out front to back from large blocks so that objects made one after the other lie next to each other.
+  create() constructs an object in the arena, reset() destroys everything created since the last reset, newest first, and rewinds to the start of the first block; the blocks are kept for the next level. Objects that go away before that (streamed or edited tiles) are destroy()ed, their memory is reused by the next allocation of the same size.
+  Allocator lets containers and std::allocate_shared put their memory into the arena as well. Nothing in the arena may outlive reset() or the arena.
+ */
+class SbArena
+{
+ public:
+  //! every allocation starts at a multiple of this
+  static const size_t alignment = alignof(std::max_align_t);
+
+  explicit SbArena(size_t block_size = 64 << 10);
+  SbArena(const SbArena&) = delete;
+  SbArena& operator=(const SbArena&) = delete;
+  ~SbArena();
+
+  void* allocate(size_t size);
+  void deallocate(void* memory, size_t size);
+
+  template <class T, class... Args>
+  T* create(Args&&... args);
+  /*! Destroy an object made by create(), also when given a pointer to its base class.
+   */
+  template <class T>
+  void destroy(T* object);
+  void reset();
+
+  //! bytes handed out since the last reset(), including the ones waiting to be reused
+  size_t used() const { return used_; }
+  //! bytes in all blocks
+  size_t capacity() const;
+  size_t n_objects() const { return n_objects_; }
+
+  template <class T>
+  class Allocator
+  {
+  public:
+    typedef T value_type;
+    explicit Allocator(SbArena* arena) : arena_(arena) {}
+    template <class U>
+    Allocator(const Allocator<U>& other) : arena_(other.arena()) {}
+    T* allocate(size_t n) { return static_cast<T*>( arena_->allocate( n * sizeof(T) ) ); }
+    void deallocate(T* memory, size_t n) { arena_->deallocate( memory, n * sizeof(T) ); }
+    SbArena* arena() const { return arena_; }
+    template <class U>
+    bool operator==(const Allocator<U>& other) const { return arena_ == other.arena(); }
+    template <class U>
+    bool operator!=(const Allocator<U>& other) const { return arena_ != other.arena(); }
+  private:
+    SbArena* arena_;
+  };
+
+ private:
+  //! in front of every created object, links it into the list reset() works through
+  struct Node
+  {
+    void (*destroy)(void*);
+    Node* previous;
+    Node* next;
+    size_t size;
+  };
+  static const size_t node_size = ( sizeof(Node) + alignment - 1 ) / alignment * alignment;
+
+  struct Block
+  {
+    std::unique_ptr<uint8_t[]> data;
+    size_t size;
+  };
+
+  struct FreeList
+  {
+    size_t size;
+    void* first;
+  };
+
+  template <class T>
+  static void destroy_object(void* object) { static_cast<T*>(object)->~T(); }
+  template <class T>
+  static void* most_derived(T* object, std::true_type) { return dynamic_cast<void*>(object); }
+  template <class T>
+  static void* most_derived(T* object, std::false_type) { return object; }
+  static size_t round_up(size_t size) { return ( size + alignment - 1 ) / alignment * alignment; }
+
+  void link(Node* node);
+  void unlink(Node* node);
+
+  size_t block_size_;
+  std::vector<Block> blocks_;
+  //! block and offset of the next allocation
+  size_t current_ = 0;
+  size_t offset_ = 0;
+  size_t used_ = 0;
+  //! newest object
+  Node* last_ = nullptr;
+  size_t n_objects_ = 0;
+  std::vector<FreeList> free_;
+};
+
+
+
+template <class T, class... Args>
+T*
+SbArena::create(Args&&... args)
+{
+  size_t size = node_size + sizeof(T);
+  static_assert( alignof(T) <= alignment, "SbArena::create: over-aligned type" );
+  uint8_t* memory = static_cast<uint8_t*>( allocate( size ) );
+  T* object = nullptr;
+  try {
+    object = new (memory + node_size) T( std::forward<Args>(args)... );
+  }
+  catch (...) {
+    deallocate( memory, size );
+    throw;
+  }
+  link( new (memory) Node{ &destroy_object<T>, nullptr, nullptr, size } );
+  return object;
+}
+
+
+
+template <class T>
+void
+SbArena::destroy(T* object)
+{
+  if ( !object )
+    return;
+  uint8_t* memory = static_cast<uint8_t*>( most_derived( object, std::is_polymorphic<T>() ) ) - node_size;
+  Node* node = reinterpret_cast<Node*>( memory );
+  unlink( node );
+  node->destroy( memory + node_size );
+  deallocate( memory, node->size );
+}
+
+
+#endif  // SBARENA_H
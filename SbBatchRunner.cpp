@@ -0,0 +1,90 @@
+/*! \file SbBatchRunner.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <SDL2/SDL.h>
+
+#include "SbGameContext.h"
+
+#include "SbBatchRunner.h"
+
+
+SbBatchRunner::SbBatchRunner(unsigned n_workers)
+  : jobs_(n_workers)
+{
+}
+
+
+
+void
+SbBatchRunner::add(Start start)
+{
+  sessions_.push_back( std::move(start) );
+}
+
+
+
+SbBatchRunner::Result
+SbBatchRunner::run(uint64_t max_ticks)
+{
+  std::vector<uint64_t> ticks( sessions_.size(), 0 );
+  Uint64 start = SDL_GetPerformanceCounter();
+  jobs_.parallel_for( 0, sessions_.size(), 1, [this, &ticks, max_ticks](size_t first, size_t last) {
+      for ( size_t i = first; i < last; ++i )
+	ticks[i] = run_session( i, max_ticks );
+    } );
+  last_.seconds = double( SDL_GetPerformanceCounter() - start ) / SDL_GetPerformanceFrequency();
+  last_.sessions = sessions_.size();
+  last_.ticks = 0;
+  for ( uint64_t n: ticks )
+    last_.ticks += n;
+  return last_;
+}
+
+
+
+uint64_t
+SbBatchRunner::run_session(size_t i, uint64_t max_ticks)
+{
+  // the calling thread helps out, give it back its own context afterwards
+  SbGameContext* previous = SbGameContext::make_current( nullptr );
+  uint64_t n_ticks = 0;
+  Tick tick;
+  try {
+    {
+      std::lock_guard<std::mutex> lock( setup_mutex_ );
+      tick = sessions_[i]();
+    }
+    while ( max_ticks == 0 || n_ticks < max_ticks ) {
+      ++n_ticks;
+      if ( !tick() )
+	break;
+    }
+  }
+  catch (...) {
+    {
+      std::lock_guard<std::mutex> lock( setup_mutex_ );
+      tick = nullptr;
+    }
+    SbGameContext::make_current( previous );
+    throw;
+  }
+  {
+    // the game goes with its tick, on the thread that made its window
+    std::lock_guard<std::mutex> lock( setup_mutex_ );
+    tick = nullptr;
+  }
+  SbGameContext::make_current( previous );
+  return n_ticks;
+}
+
+
+
+std::ostream&
+SbBatchRunner::print_statistics(std::ostream& os) const
+{
+  os << "ran " << last_.sessions << " sessions on " << jobs_.n_workers() + 1 << " threads: " << last_.ticks << " ticks in "
+     << last_.seconds << " s (" << last_.ticks_per_second() << " ticks/s)" << std::endl;
+  return os;
+}
@@ -0,0 +1,62 @@
+/*! \file SbBatchRunner.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBBATCHRUNNER_H
+#define SBBATCHRUNNER_H
+
+#include <vector>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+#include "SbJobSystem.h"
+
+/*! Runs many independent game sessions side by side on an SbJobSystem, e.g. headless Maze or Platformer instances driven by scripts or replays, to use the games as a throughput benchmark.
+  Every session runs as one job from start to end: the job sets the session up, ticks it and tears it down, all on one thread. SDL only supports a renderer on the thread that created it, so the game of a session, with its window and renderer, has to be created in Start and be owned by the Tick it returns, which is destroyed on the same thread. Setting up and tearing down take a lock, as creating windows and opening fonts change state SDL and SDL_ttf share between all windows and fonts. A tick is one frame of a session.
+ */
+class SbBatchRunner
+{
+ public:
+  /*! Advances the session by one frame, returns false once the session has finished.
+   */
+  typedef std::function<bool()> Tick;
+  /*! Creates the game of a session on the thread that runs it and returns its Tick, which owns the game.
+   */
+  typedef std::function<Tick()> Start;
+
+  struct Result
+  {
+    size_t sessions = 0;
+    uint64_t ticks = 0;
+    double seconds = 0;
+    double ticks_per_second() const { return seconds > 0 ? ticks / seconds : 0; }
+  };
+
+  /*! n_workers threads besides the caller, see SbJobSystem.
+   */
+  explicit SbBatchRunner(unsigned n_workers = SbJobSystem::default_workers());
+  SbBatchRunner(const SbBatchRunner&) = delete;
+  SbBatchRunner& operator=(const SbBatchRunner&) = delete;
+
+  void add(Start start);
+  /*! Run every session until it finishes or has run max_ticks ticks (0: no limit). Exceptions of a session are rethrown once all have stopped.
+   */
+  Result run(uint64_t max_ticks = 0);
+  size_t size() const { return sessions_.size(); }
+  std::ostream& print_statistics(std::ostream& os) const;
+
+ private:
+  //! runs session i to the end, returns its ticks
+  uint64_t run_session(size_t i, uint64_t max_ticks);
+
+  SbJobSystem jobs_;
+  std::vector<Start> sessions_;
+  //! held while a session is set up or torn down
+  std::mutex setup_mutex_;
+  Result last_;
+};
+
+
+#endif  // SBBATCHRUNNER_H
@@ -0,0 +1,243 @@
+/*! \file SbBench.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <stdexcept>
+
+#include "SbTexture.h"
+#include "SbWindow.h"
+#include "SbMessage.h"
+#include "SbHighScoreStore.h"
+#include "SbResourcePack.h"
+#include "SbPixelCache.h"
+#include "SbDrawList.h"
+#include "SbEventDispatcher.h"
+#include "SbInput.h"
+#include "SbEventSource.h"
+#include "SbTimerWheel.h"
+#include "SbGameContext.h"
+
+#include "SbBench.h"
+
+
+volatile int64_t SbBench::sink_ = 0;
+
+
+SbBench::SbBench(std::string suite, std::ostream& os)
+  : suite_(suite), os_(os)
+{
+}
+
+
+void
+SbBench::run(const std::string& name, uint64_t n, const std::function<void()>& op)
+{
+  typedef std::chrono::steady_clock clock;
+  op();  // warm up
+  uint64_t batch = 1, iterations = 0;
+  clock::duration elapsed = clock::duration::zero();
+  const clock::duration min_time = std::chrono::milliseconds(min_time_ms_);
+  while ( elapsed < min_time ) {
+    clock::time_point start = clock::now();
+    for ( uint64_t i = 0; i < batch; ++i )
+      op();
+    elapsed += clock::now() - start;
+    iterations += batch;
+    batch *= 2;
+  }
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+  os_ << "{\"suite\":\"" << suite_ << "\",\"bench\":\"" << name << "\",\"n\":" << n
+      << ",\"iterations\":" << iterations << ",\"ns_per_op\":" << ns << "}" << std::endl;
+}
+
+
+
+void
+run_core_benchmarks(SbBench& bench, std::shared_ptr<TTF_Font> font, const SbDimension* ref)
+{
+  // check_hit against a box that is hit and one that is missed
+  SbObject mover(SDL_Rect{100, 100, 25, 25}, ref);
+  SbObject hit(SDL_Rect{110, 90, 200, 20}, ref);
+  SbObject miss(SDL_Rect{500, 500, 200, 20}, ref);
+  bench.run("check_hit", 1, [&]() { SbBench::keep( int(mover.check_hit(hit)) + int(mover.check_hit(miss)) ); } );
+
+  // a frame of 64 objects in 4 layers, half of them hidden by their tag, from an SbDrawList and, as HalfPong did, filtered by name
+  std::vector<std::unique_ptr<SbObject>> drawn;
+  SbDrawList draw_list;
+  for ( int i = 0; i < 64; ++i ) {
+    drawn.emplace_back( new SbObject( SDL_Rect{ 10*i, 10, 8, 8 }, ref ) );
+    drawn.back()->set_layer( 3 - i % 4 );
+    drawn.back()->set_tags( i % 2 ? SB_TAG_DEFAULT : SB_TAG_DEFAULT << 1 );
+    draw_list.add( drawn.back().get() );
+  }
+  bench.run("draw_list_render", drawn.size(), [&]() { draw_list.render( SB_TAG_DEFAULT ); } );
+  bench.run("name_filter_render", drawn.size(), [&]() {
+      for ( auto& object: drawn )
+	if ( object->name() != "gameover" ) object->render();
+    } );
+
+  // a mouse motion, which no object wants, and a key press wanted by one object, to the same 64 objects through an SbEventDispatcher and, as HalfPong did, to all of them
+  SbEventDispatcher dispatcher;
+  dispatcher.subscribe_key( SDLK_f, drawn.front().get() );
+  SDL_Event events[2] = {};
+  events[0].type = SDL_MOUSEMOTION;
+  events[1].type = SDL_KEYDOWN;
+  events[1].key.keysym.sym = SDLK_f;
+  bench.run("event_dispatch", drawn.size(), [&]() {
+      for ( const SDL_Event& event: events )
+	SbBench::keep( dispatcher.dispatch( event ) );
+    } );
+  bench.run("event_broadcast", drawn.size(), [&]() {
+      for ( const SDL_Event& event: events )
+	for ( auto& object: drawn ) object->handle_event( event );
+    } );
+
+  // a frame's burst of 64 mouse motions, 32 stick motions on two axes and 16 resizes around two key presses, copied and coalesced into 5 events
+  std::vector<SDL_Event> burst;
+  for ( int i = 0; i < 112; ++i ) {
+    SDL_Event event = {};
+    if ( i < 64 ) {
+      event.type = SDL_MOUSEMOTION;
+      event.motion.xrel = 1;
+    }
+    else if ( i < 96 ) {
+      event.type = SDL_CONTROLLERAXISMOTION;
+      event.jaxis.axis = i % 2;
+      event.jaxis.value = 100 * i;
+    }
+    else {
+      event.type = SDL_WINDOWEVENT;
+      event.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+      event.window.data1 = 10 * i;
+    }
+    burst.push_back( event );
+    if ( i == 40 || i == 80 ) {
+      SDL_Event key = {};
+      key.type = SDL_KEYDOWN;
+      burst.push_back( key );
+    }
+  }
+  std::vector<SDL_Event> queue;
+  bench.run("event_coalesce", burst.size(), [&]() {
+      queue = burst;
+      SbBench::keep( SbEventSource::coalesce( queue ) );
+    } );
+
+  // one frame of input with the default bindings
+  SbInput input;
+  bench.run("input_sample", 1, [&]() { SbBench::keep( input.sample().held ); } );
+
+  // a timer scheduled and cancelled; a 16 ms frame of n repeating timers with periods spread over 10 s
+  SbTimerWheel wheel;
+  bench.run("timer_schedule_cancel", 1, [&]() { wheel.cancel( wheel.schedule( 1500, []() {} ) ); } );
+  for ( uint64_t n: {1024, 16384} ) {
+    SbTimerWheel timers;
+    int64_t fired = 0;
+    for ( uint64_t i = 0; i < n; ++i ) {
+      Uint32 period = 1 + ( i * 7919 ) % 10000;
+      timers.schedule( period, [&fired]() { ++fired; }, period );
+    }
+    bench.run("timer_wheel_frame", n, [&]() { timers.advance( 16 ); } );
+    SbBench::keep( fired );
+  }
+
+  for ( uint64_t length: {4, 16, 64} ) {
+    SbMessage message(SbRectangle{0, 0, 0.3, 0.05}, ref);
+    message.set_font(font);
+    std::string text(length, 'x');
+    bench.run("message_set_text", length, [&]() { message.set_text(text); } );
+  }
+
+  SbTexture texture;
+  SDL_Color color = {40, 40, 160, 0};
+  for ( int side: {16, 64, 256, 1024} ) {
+    bench.run("texture_from_rectangle", side, [&]() { texture.from_rectangle( SbObject::window()->renderer(), side, side, color ); } );
+  }
+
+  // a new record is only queued, the writer thread appends it to the journal
+  {
+    SbHighScoreStore store("bench.save");
+    uint32_t score = 0;
+    bench.run("highscore_set", 1, [&]() { store.set( 0, ++score ); } );
+  }
+  std::remove( "bench.save" );
+
+  // a resource read from disk and out of a resource pack
+  SbResourcePack::write( "bench.pack", {"resources/ball.png"} );
+  check_file_types( "bench.pack", "bench.replay" );
+  std::remove( "bench.replay" );
+  {
+    SbResourcePack pack("bench.pack");
+    std::vector<uint8_t> buffer(4096);
+    auto read_all = [&buffer](SDL_RWops* file) { SbBench::keep( SDL_RWread( file, buffer.data(), 1, buffer.size() ) ); SDL_RWclose( file ); };
+    bench.run("resource_read_file", 1, [&]() { read_all( SDL_RWFromFile( "resources/ball.png", "rb" ) ); } );
+    bench.run("resource_read_pack", 1, [&]() { size_t size = 0; const uint8_t* data = pack.find( "resources/ball.png", size ); read_all( SDL_RWFromConstMem( data, size ) ); } );
+  }
+  std::remove( "bench.pack" );
+
+  // ball.png decoded every time (cold start) and uploaded from the pixel cache (warm start)
+  std::string cache_directory = SbPixelCache::directory();
+  SbPixelCache::set_directory( "" );
+  bench.run("texture_from_file_cold", 1, [&]() { texture.from_file( SbObject::window()->renderer(), "resources/ball.png" ); } );
+  SbPixelCache::set_directory( "bench_cache" );
+  texture.from_file( SbObject::window()->renderer(), "resources/ball.png" );
+  bench.run("texture_from_file_warm", 1, [&]() { texture.from_file( SbObject::window()->renderer(), "resources/ball.png" ); } );
+  std::remove( SbPixelCache::cache_file( "resources/ball.png" ).c_str() );
+  std::remove( "bench_cache" );
+  SbPixelCache::set_directory( cache_directory );
+}
+
+
+
+void
+check_file_types(const std::string& pack, const std::string& replay)
+{
+  // recorded in a context of its own, recording fixes the clock
+  SbGameContext context;
+  SbGameContext* previous = SbGameContext::make_current( &context );
+  {
+    SbEventSource recording;
+    recording.record( replay );
+  }
+  bool pack_rejected = false, replay_rejected = false;
+  try {
+    SbEventSource events;
+    events.replay( pack );
+  }
+  catch (const std::runtime_error&) {
+    pack_rejected = true;
+  }
+  try {
+    SbResourcePack resources( replay );
+  }
+  catch (const std::runtime_error&) {
+    replay_rejected = true;
+  }
+  SbGameContext::make_current( previous );
+  if ( !pack_rejected )
+    throw std::runtime_error("[check_file_types] Error: resource pack " + pack + " was accepted as a recording" );
+  if ( !replay_rejected )
+    throw std::runtime_error("[check_file_types] Error: recording " + replay + " was accepted as a resource pack" );
+}
+
+
+
+void
+bench_init(SbBench& bench, int argc, char* argv[])
+{
+  for ( int i = 1; i < argc; ++i ) {
+    std::string arg = argv[i];
+    if ( arg == "--min-time" && i+1 < argc )
+      bench.set_min_time( std::stoul( argv[++i] ) );
+    else {
+      std::cerr << "usage: " << argv[0] << " [--min-time ms]" << std::endl;
+      exit(1);
+    }
+  }
+  sdl_init(true);
+}
@@ -0,0 +1,61 @@
+/*! \file SbBench.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBBENCH_H
+#define SBBENCH_H
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <functional>
+#include <memory>
+
+#include <SDL2/SDL_ttf.h>
+
+#include "SbObject.h"
+
+
+/*! Minimal microbenchmark runner. Every result is printed as one JSON object per line:
+  {"suite":"maze","bench":"ball_move","n":256,"iterations":51200,"ns_per_op":812.5}
+  n is the problem size of the case (number of tiles, texture side, ...), running a case for several n gives the scaling curve.
+ */
+class SbBench
+{
+ public:
+  SbBench(std::string suite, std::ostream& os = std::cout);
+
+  /*! Calls op until at least min_time_ms have passed, doubling the batch size each round, and reports the time per call.
+   */
+  void run(const std::string& name, uint64_t n, const std::function<void()>& op);
+  void set_min_time(uint32_t ms) { min_time_ms_ = ms; }
+
+  /*! Keeps the compiler from dropping results that are otherwise unused.
+   */
+  static void keep(int64_t value) { sink_ += value; }
+  
+ private:
+  std::string suite_;
+  std::ostream& os_;
+  uint32_t min_time_ms_ = 200;
+  static volatile int64_t sink_;
+};
+
+
+/*! Benchmarks of the classes shared by all games: SbObject::check_hit, SbDrawList::render, SbEventDispatcher::dispatch, SbEventSource::coalesce, SbInput::sample, SbTimerWheel, SbMessage::set_text, SbTexture::from_rectangle, SbHighScoreStore::set, reading a resource from disk and from an SbResourcePack, SbTexture::from_file with and without the SbPixelCache.
+  Needs SbObject::window() to point to an open window, i.e. a game constructed on the calling thread.
+ */
+void run_core_benchmarks(SbBench& bench, std::shared_ptr<TTF_Font> font, const SbDimension* ref);
+
+/*! Records an empty replay to the file replay and throws if SbEventSource::replay() accepts the resource pack pack or SbResourcePack accepts the recording. Run by run_core_benchmarks.
+ */
+void check_file_types(const std::string& pack, const std::string& replay);
+
+/*! Parses the common benchmark options (--min-time ms) and initializes SDL headless.
+ */
+void bench_init(SbBench& bench, int argc, char* argv[]);
+
+
+#endif  // SBBENCH_H
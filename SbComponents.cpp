@@ -0,0 +1,171 @@
+/*! \file SbComponents.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include "SbTexture.h"
+#include "SbSnapshot.h"
+#include "SbJobSystem.h"
+
+#include "SbComponents.h"
+
+
+SbComponentStore::Entity
+SbComponentStore::create(SbRectangle bounding_box, std::shared_ptr<SbTexture> sprite)
+{
+  if ( !reference_ )
+    throw std::runtime_error("[SbComponentStore::create] Error: no reference dimension");
+  Entity entity = rects_.size();
+  boxes_.push_back( bounding_box );
+  rects_.push_back( SDL_Rect{ static_cast<int>(bounding_box.x * reference_->w)
+	, static_cast<int>(bounding_box.y * reference_->h)
+	, static_cast<int>(bounding_box.w * reference_->w)
+	, static_cast<int>(bounding_box.h * reference_->h) } );
+  sprites_.push_back( std::move(sprite) );
+  motion_of_.push_back( -1 );
+  return entity;
+}
+
+
+
+void
+SbComponentStore::add_motion(Entity entity, Velocity velocity, MovementLimits range)
+{
+  if ( entity >= size() )
+    throw std::runtime_error("[SbComponentStore::add_motion] Error: no entity " + std::to_string(entity) );
+  const SDL_Rect& rect = rects_[entity];
+  SbBounds bounds;
+  bounds.left = rect.x - range.left;
+  bounds.right = rect.x + rect.w + range.right;
+  bounds.top = rect.y - range.top;
+  bounds.bottom = rect.y + rect.h + range.bottom;
+  bounds.bounce_x = ( velocity.x > 0 && bounds.left != bounds.right );
+  bounds.bounce_y = ( velocity.y > 0 && bounds.top != bounds.bottom );
+  if ( motion_of_[entity] < 0 ) {
+    motion_of_[entity] = moving_.size();
+    moving_.push_back( entity );
+    velocities_.push_back( velocity );
+    bounds_.push_back( bounds );
+  }
+  else {
+    velocities_[ motion_of_[entity] ] = velocity;
+    bounds_[ motion_of_[entity] ] = bounds;
+  }
+}
+
+
+
+void
+SbComponentStore::clear()
+{
+  boxes_.clear();
+  rects_.clear();
+  sprites_.clear();
+  motion_of_.clear();
+  moving_.clear();
+  velocities_.clear();
+  bounds_.clear();
+}
+
+
+
+Velocity
+SbComponentStore::velocity(Entity entity) const
+{
+  int32_t motion = motion_of_.at(entity);
+  return ( motion < 0 ) ? Velocity() : velocities_[motion];
+}
+
+
+
+void
+SbComponentStore::save_state(SbSnapshot& snapshot) const
+{
+  for ( size_t i = 0; i < moving_.size(); ++i ) {
+    snapshot.write( boxes_[ moving_[i] ] );
+    snapshot.write( rects_[ moving_[i] ] );
+    snapshot.write( velocities_[i] );
+  }
+}
+
+
+
+void
+SbComponentStore::restore_state(SbSnapshot& snapshot)
+{
+  for ( size_t i = 0; i < moving_.size(); ++i ) {
+    snapshot.read( boxes_[ moving_[i] ] );
+    snapshot.read( rects_[ moving_[i] ] );
+    snapshot.read( velocities_[i] );
+  }
+}
+
+
+
+void
+SbSystems::move(SbComponentStore& store, Uint32 delta_t)
+{
+  move_range( store, delta_t, 0, store.moving_.size() );
+}
+
+
+
+void
+SbSystems::move(SbComponentStore& store, Uint32 delta_t, SbJobSystem& jobs, size_t grain)
+{
+  jobs.parallel_for( 0, store.moving_.size(), grain,
+		     [&store, delta_t](size_t begin, size_t end) { move_range( store, delta_t, begin, end ); } );
+}
+
+
+
+void
+SbSystems::move_range(SbComponentStore& store, Uint32 delta_t, size_t begin, size_t end)
+{
+  const double width = store.reference_->w;
+  const double height = store.reference_->h;
+  for ( size_t i = begin; i < end; ++i ) {
+    SbRectangle& box = store.boxes_[ store.moving_[i] ];
+    SDL_Rect& rect = store.rects_[ store.moving_[i] ];
+    Velocity& velocity = store.velocities_[i];
+    const SbBounds& bounds = store.bounds_[i];
+    if ( bounds.bounce_x ) {
+      if ( rect.x + rect.w >= bounds.right ) {
+	if ( velocity.x > 0 ) velocity.x *= -1;
+      }
+      else if ( rect.x < bounds.left ) {
+	if ( velocity.x < 0 ) velocity.x *= -1;
+      }
+    }
+    if ( bounds.bounce_y ) {
+      if ( rect.y + rect.h >= bounds.bottom ) {
+	if ( velocity.y > 0 ) velocity.y *= -1;
+      }
+      else if ( rect.y < bounds.top ) {
+	if ( velocity.y < 0 ) velocity.y *= -1;
+      }
+    }
+    box.x += velocity.x * delta_t;
+    box.y += velocity.y * delta_t;
+    rect.x = int( box.x * width );
+    rect.y = int( box.y * height );
+  }
+}
+
+
+
+void
+SbSystems::render(const SbComponentStore& store, SDL_Renderer* renderer, const SDL_Rect& camera)
+{
+  for ( size_t i = 0; i < store.rects_.size(); ++i ) {
+    const SDL_Rect& rect = store.rects_[i];
+    if ( !store.sprites_[i] || rect.x > camera.x + camera.w || rect.x + rect.w < camera.x
+	 || rect.y > camera.y + camera.h || rect.y + rect.h < camera.y )
+      continue;
+    SDL_Rect camera_adjusted = { rect.x - camera.x, rect.y - camera.y, rect.w, rect.h };
+    store.sprites_[i]->render( renderer, &camera_adjusted );
+  }
+}
@@ -0,0 +1,105 @@
+/*! \file SbComponents.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBCOMPONENTS_H
+#define SBCOMPONENTS_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+#include "SbObject.h"
+#include "SbLevelFile.h"
+
+class SbTexture;
+class SbJobSystem;
+
+
+/*! Range an entity bounces back and forth in, in pixels, as Platform::set_limits() had it. A direction only bounces if the entity started out moving in it.
+ */
+struct SbBounds
+{
+  int left = 0;
+  int right = 0;
+  int top = 0;
+  int bottom = 0;
+  bool bounce_x = false;
+  bool bounce_y = false;
+};
+
+
+
+/*! Entities as indices into arrays, one array per component, instead of one SbObject each.
+  Every entity has a transform (bounding_box relative to the reference dimension and rect in pixels, rect doubling as the collider) and a sprite, which may be empty. Only entities given a motion have velocity and bounds, those are kept apart so that the motion system only looks at the ones that move.
+  Entities are never removed one at a time, clear() drops all of them.
+ */
+class SbComponentStore
+{
+ public:
+  typedef uint32_t Entity;
+
+  SbComponentStore(const SbDimension* reference = nullptr) : reference_(reference) {}
+
+  Entity create(SbRectangle bounding_box, std::shared_ptr<SbTexture> sprite = nullptr);
+  /*! Let entity move with velocity, bouncing within range pixels around where it is now.
+   */
+  void add_motion(Entity entity, Velocity velocity, MovementLimits range);
+  void clear();
+  void set_reference(const SbDimension* reference) { reference_ = reference; }
+  size_t size() const { return rects_.size(); }
+  size_t n_moving() const { return moving_.size(); }
+
+  const SDL_Rect& rect(Entity entity) const { return rects_[entity]; }
+  const std::vector<SDL_Rect>& rects() const { return rects_; }
+  //! zero for entities without a motion
+  Velocity velocity(Entity entity) const;
+
+  /*! Transforms and velocities of the entities that move, the rest does not change after create().
+   */
+  void save_state(SbSnapshot& snapshot) const;
+  void restore_state(SbSnapshot& snapshot);
+
+ private:
+  friend class SbSystems;
+
+  const SbDimension* reference_;
+  // per entity
+  std::vector<SbRectangle> boxes_;
+  std::vector<SDL_Rect> rects_;
+  std::vector<std::shared_ptr<SbTexture>> sprites_;
+  //! position in moving_ of each entity, -1 if it has no motion
+  std::vector<int32_t> motion_of_;
+  // per entity with a motion
+  std::vector<Entity> moving_;
+  std::vector<Velocity> velocities_;
+  std::vector<SbBounds> bounds_;
+};
+
+
+
+/*! The per-frame work on an SbComponentStore, each a straight pass over the arrays it needs.
+ */
+class SbSystems
+{
+ public:
+  /*! Turn around the entities that reached their bounds and move all moving entities by their velocity for delta_t ms.
+   */
+  static void move(SbComponentStore& store, Uint32 delta_t);
+  /*! As move(), in chunks of grain movers on the jobs. Every mover only touches its own entity, so the result is the same.
+   */
+  static void move(SbComponentStore& store, Uint32 delta_t, SbJobSystem& jobs, size_t grain = 2048);
+  /*! Draw the sprites of the entities that overlap the camera.
+   */
+  static void render(const SbComponentStore& store, SDL_Renderer* renderer, const SDL_Rect& camera);
+
+ private:
+  //! move the movers [begin, end)
+  static void move_range(SbComponentStore& store, Uint32 delta_t, size_t begin, size_t end);
+};
+
+
+#endif  // SBCOMPONENTS_H
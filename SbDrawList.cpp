@@ -0,0 +1,73 @@
+/*! \file SbDrawList.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+
+#include "SbDrawList.h"
+
+
+void
+SbDrawList::insert(const Entry& entry)
+{
+  auto position = std::upper_bound( entries_.begin(), entries_.end(), entry,
+				    [](const Entry& a, const Entry& b) {
+				      return a.layer < b.layer || ( a.layer == b.layer && a.sequence < b.sequence );
+				    } );
+  entries_.insert( position, entry );
+}
+
+
+
+void
+SbDrawList::add(SbObject* object)
+{
+  insert( Entry{ object->layer(), object->tags(), next_sequence_++, object } );
+}
+
+
+
+void
+SbDrawList::remove(SbObject* object)
+{
+  entries_.erase( std::remove_if( entries_.begin(), entries_.end(), [object](const Entry& entry) { return entry.object == object; } )
+		  , entries_.end() );
+}
+
+
+
+void
+SbDrawList::update(SbObject* object)
+{
+  auto found = std::find_if( entries_.begin(), entries_.end(), [object](const Entry& entry) { return entry.object == object; } );
+  if ( found == entries_.end() )
+    return;
+  Entry entry = *found;
+  entry.layer = object->layer();
+  entry.tags = object->tags();
+  entries_.erase( found );
+  insert( entry );
+}
+
+
+
+void
+SbDrawList::render(uint32_t visible) const
+{
+  for ( const Entry& entry: entries_ ) {
+    if ( entry.tags & visible )
+      entry.object->render();
+  }
+}
+
+
+
+void
+SbDrawList::render(uint32_t visible, const SDL_Rect& camera) const
+{
+  for ( const Entry& entry: entries_ ) {
+    if ( entry.tags & visible )
+      entry.object->render( camera );
+  }
+}
@@ -0,0 +1,50 @@
+/*! \file SbDrawList.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBDRAWLIST_H
+#define SBDRAWLIST_H
+
+#include <vector>
+#include <cstdint>
+
+#include "SbObject.h"
+
+
+/*! Objects to draw, kept sorted by SbObject::layer() so that a frame is one pass over the list.
+  Objects of the same layer are drawn in the order they were added. Layer and tags are copied when an object is added, call update() for an object whose layer or tags changed. The list does not own the objects.
+ */
+class SbDrawList
+{
+ public:
+  void add(SbObject* object);
+  void remove(SbObject* object);
+  //! re-read layer and tags of object
+  void update(SbObject* object);
+  void clear() { entries_.clear(); }
+  size_t size() const { return entries_.size(); }
+
+  /*! Draw, lowest layer first, the objects that have a tag in visible.
+   */
+  void render(uint32_t visible) const;
+  void render(uint32_t visible, const SDL_Rect& camera) const;
+
+ private:
+  struct Entry
+  {
+    int layer;
+    uint32_t tags;
+    //! order of adding, keeps objects of the same layer in order when one is moved
+    uint64_t sequence;
+    SbObject* object;
+  };
+
+  void insert(const Entry& entry);
+
+  std::vector<Entry> entries_;
+  uint64_t next_sequence_ = 0;
+};
+
+
+#endif  // SBDRAWLIST_H
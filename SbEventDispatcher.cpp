@@ -0,0 +1,89 @@
+/*! \file SbEventDispatcher.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+
+#include "SbEventDispatcher.h"
+
+
+void
+SbEventDispatcher::subscribe(Uint32 type, Handler handler, const void* owner)
+{
+  if ( type >= by_type_.size() )
+    by_type_.resize( type + 1 );
+  by_type_[type].push_back( Subscriber{ std::move(handler), owner } );
+}
+
+
+
+void
+SbEventDispatcher::subscribe(Uint32 type, SbObject* object)
+{
+  subscribe( type, [object](const SDL_Event& event) { object->handle_event( event ); }, object );
+}
+
+
+
+void
+SbEventDispatcher::subscribe_key(SDL_Keycode key, Handler handler, const void* owner)
+{
+  by_key_[key].push_back( Subscriber{ std::move(handler), owner } );
+}
+
+
+
+void
+SbEventDispatcher::subscribe_key(SDL_Keycode key, SbObject* object)
+{
+  subscribe_key( key, [object](const SDL_Event& event) { object->handle_event( event ); }, object );
+}
+
+
+
+void
+SbEventDispatcher::unsubscribe(const void* owner)
+{
+  auto owned = [owner](const Subscriber& subscriber) { return subscriber.owner == owner; };
+  for ( auto& subscribers: by_type_ )
+    subscribers.erase( std::remove_if( subscribers.begin(), subscribers.end(), owned ), subscribers.end() );
+  for ( auto entry = by_key_.begin(); entry != by_key_.end(); ) {
+    entry->second.erase( std::remove_if( entry->second.begin(), entry->second.end(), owned ), entry->second.end() );
+    if ( entry->second.empty() )
+      entry = by_key_.erase( entry );
+    else
+      ++entry;
+  }
+}
+
+
+
+void
+SbEventDispatcher::clear()
+{
+  by_type_.clear();
+  by_key_.clear();
+}
+
+
+
+size_t
+SbEventDispatcher::dispatch(const SDL_Event& event) const
+{
+  size_t n_called = 0;
+  if ( ( event.type == SDL_KEYDOWN || event.type == SDL_KEYUP ) && !by_key_.empty() ) {
+    auto found = by_key_.find( event.key.keysym.sym );
+    if ( found != by_key_.end() ) {
+      for ( const Subscriber& subscriber: found->second )
+	subscriber.handler( event );
+      n_called += found->second.size();
+    }
+  }
+  if ( event.type < by_type_.size() ) {
+    for ( const Subscriber& subscriber: by_type_[event.type] )
+      subscriber.handler( event );
+    n_called += by_type_[event.type].size();
+  }
+  return n_called;
+}
@@ -0,0 +1,56 @@
+/*! \file SbEventDispatcher.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBEVENTDISPATCHER_H
+#define SBEVENTDISPATCHER_H
+
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+#include "SbObject.h"
+
+
+/*! Hands each event only to whoever subscribed to its type, or for key presses and releases to its key, instead of to every object.
+  Subscribers of a type are found by indexing a table with the event type, subscribers of a key in a hash table by keycode, so the cost of an event depends on the number of its subscribers only. A key press goes to the subscribers of its key and then to those of SDL_KEYDOWN, if any.
+  The table grows to the largest type subscribed to; user event types (SDL_USEREVENT and up) make it large and are better handled elsewhere.
+ */
+class SbEventDispatcher
+{
+ public:
+  typedef std::function<void(const SDL_Event&)> Handler;
+
+  /*! Call handler for every event of type. owner is only used to unsubscribe().
+   */
+  void subscribe(Uint32 type, Handler handler, const void* owner = nullptr);
+  //! object->handle_event() for every event of type
+  void subscribe(Uint32 type, SbObject* object);
+  /*! Call handler for SDL_KEYDOWN and SDL_KEYUP events of key.
+   */
+  void subscribe_key(SDL_Keycode key, Handler handler, const void* owner = nullptr);
+  void subscribe_key(SDL_Keycode key, SbObject* object);
+  //! drop all subscriptions made with owner
+  void unsubscribe(const void* owner);
+  void clear();
+
+  /*! Returns the number of handlers called.
+   */
+  size_t dispatch(const SDL_Event& event) const;
+
+ private:
+  struct Subscriber
+  {
+    Handler handler;
+    const void* owner;
+  };
+
+  std::vector<std::vector<Subscriber>> by_type_;
+  std::unordered_map<SDL_Keycode, std::vector<Subscriber>> by_key_;
+};
+
+
+#endif  // SBEVENTDISPATCHER_H
@@ -0,0 +1,460 @@
+/*! \file SbEventSource.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#include "SbTimer.h"
+#include "SbGameContext.h"
+
+#include "SbEventSource.h"
+
+
+namespace {
+  const char magic[4] = {'S','B','R','P'};
+  const uint64_t version = 1;
+  //! recorded data is written in chunks of this size
+  const size_t flush_size = 1 << 16;
+}
+
+
+SbEventSource::~SbEventSource()
+{
+  if ( mode_ == Mode::record ) {
+    write_frame();
+    flush();
+    SDL_RWclose( file_ );
+  }
+  if ( context_ && context_->replay_keys == keys_.data() )
+    context_->replay_keys = nullptr;
+}
+
+
+
+void
+SbEventSource::begin_frame()
+{
+  switch ( mode_ ) {
+  case Mode::live:
+    drain();
+    break;
+  case Mode::record: {
+    write_frame();
+    Uint32 now = SDL_GetTicks();
+    write_unsigned( now - time_ );
+    time_ = now;
+    SbTimer::set_fixed_time( time_ );
+    if ( buffer_.size() > flush_size )
+      flush();
+    drain();
+    break;
+  }
+  case Mode::replay:
+    // skip events the loop did not poll
+    while ( pending_events_ > 0 ) {
+      SDL_Event event;
+      read_event(event);
+    }
+    if ( position_ >= buffer_.size() )
+      return;
+    time_ += read_unsigned();
+    SbTimer::set_fixed_time( time_ );
+    for ( uint64_t n = read_unsigned(); n > 0; --n ) {
+      uint64_t scancode = read_unsigned();
+      if ( scancode >= keys_.size() )
+	throw std::runtime_error("[SbEventSource::begin_frame] Error: bad scancode in " + filename_ );
+      keys_[scancode] = !keys_[scancode];
+    }
+    pending_events_ = read_unsigned();
+    break;
+  case Mode::script:
+    queue_.clear();
+    next_ = 0;
+    if ( quit_sent_ )
+      return;
+    time_ += frame_ms_;
+    SbTimer::set_fixed_time( time_ );
+    if ( !script_( frame_, keys_.data(), queue_ ) ) {
+      SDL_Event quit;
+      std::memset( &quit, 0, sizeof(quit) );
+      quit.type = SDL_QUIT;
+      queue_.push_back( quit );
+      quit_sent_ = true;
+    }
+    break;
+  }
+  ++frame_;
+}
+
+
+
+bool
+SbEventSource::poll(SDL_Event& event)
+{
+  if ( mode_ == Mode::replay ) {
+    if ( pending_events_ > 0 ) {
+      --pending_events_;
+      // events the games do not handle were recorded by type only, read_event() returns false for them, skip over them
+      while ( !read_event(event) ) {
+	if ( pending_events_ == 0 )
+	  return false;
+	--pending_events_;
+      }
+      return true;
+    }
+    if ( position_ >= buffer_.size() && !quit_sent_ ) {
+      std::memset( &event, 0, sizeof(event) );
+      event.type = SDL_QUIT;
+      quit_sent_ = true;
+      return true;
+    }
+    return false;
+  }
+
+  if ( coalescing_ || mode_ == Mode::script ) {
+    if ( next_ >= queue_.size() )
+      return false;
+    event = queue_[next_++];
+  }
+  else if ( !SDL_PollEvent( &event ) )
+    return false;
+  if ( mode_ == Mode::record )
+    frame_events_.push_back( event );
+  return true;
+}
+
+
+
+void
+SbEventSource::record(const std::string& filename)
+{
+  file_ = SDL_RWFromFile( filename.c_str(), "wb" );
+  if ( !file_ )
+    throw std::runtime_error("[SbEventSource::record] Error: Couldn't open file " + filename + ":\n" + SDL_GetError() );
+  filename_ = filename;
+  mode_ = Mode::record;
+  buffer_.assign( magic, magic + sizeof(magic) );
+  write_unsigned( version );
+  time_ = SDL_GetTicks();
+  write_unsigned( time_ );
+  SbTimer::set_fixed_time( time_ );
+  // keys_ holds the last recorded keyboard state
+  keys_.fill(0);
+}
+
+
+
+void
+SbEventSource::replay(const std::string& filename)
+{
+  SDL_RWops* file = SDL_RWFromFile( filename.c_str(), "rb" );
+  if ( !file )
+    throw std::runtime_error("[SbEventSource::replay] Error: Couldn't open file " + filename + ":\n" + SDL_GetError() );
+  Sint64 size = SDL_RWsize( file );
+  buffer_.resize( size > 0 ? size : 0 );
+  size_t read = buffer_.empty() ? 0 : SDL_RWread( file, buffer_.data(), buffer_.size(), 1 );
+  SDL_RWclose( file );
+  filename_ = filename;
+  if ( read != 1 || buffer_.size() < sizeof(magic) || std::memcmp( buffer_.data(), magic, sizeof(magic) ) != 0 )
+    throw std::runtime_error("[SbEventSource::replay] Error: " + filename + " is not a recording" );
+  position_ = sizeof(magic);
+  if ( read_unsigned() != version )
+    throw std::runtime_error("[SbEventSource::replay] Error: unsupported version of " + filename );
+  time_ = read_unsigned();
+  SbTimer::set_fixed_time( time_ );
+  mode_ = Mode::replay;
+  keys_.fill(0);
+  context_ = &SbGameContext::current();
+  context_->replay_keys = keys_.data();
+  frame_ = 0;
+  start_counter_ = SDL_GetPerformanceCounter();
+}
+
+
+
+void
+SbEventSource::script(Script script, Uint32 frame_ms)
+{
+  if ( mode_ == Mode::record )
+    throw std::runtime_error("[SbEventSource::script] Error: already recording to " + filename_ );
+  script_ = std::move(script);
+  frame_ms_ = frame_ms;
+  mode_ = Mode::script;
+  time_ = SbTimer::now();
+  SbTimer::set_fixed_time( time_ );
+  keys_.fill(0);
+  context_ = &SbGameContext::current();
+  context_->replay_keys = keys_.data();
+  frame_ = 0;
+  quit_sent_ = false;
+  start_counter_ = SDL_GetPerformanceCounter();
+}
+
+
+
+std::ostream&
+SbEventSource::print_statistics(std::ostream& os)
+{
+  double seconds = double( SDL_GetPerformanceCounter() - start_counter_ ) / SDL_GetPerformanceFrequency();
+  os << "replayed " << frame_ << " frames of " << filename_ << " in " << seconds << " s ("
+     << ( seconds > 0 ? frame_ / seconds : 0 ) << " frames/s)" << std::endl;
+  return os;
+}
+
+
+
+void
+SbEventSource::drain()
+{
+  queue_.clear();
+  next_ = 0;
+  if ( !coalescing_ )
+    return;
+  SDL_Event event;
+  while ( SDL_PollEvent( &event ) )
+    queue_.push_back( event );
+  n_coalesced_ += coalesce( queue_ );
+}
+
+
+
+size_t
+SbEventSource::coalesce(std::vector<SDL_Event>& events)
+{
+  // output positions of the events that later ones can still be merged into
+  const size_t none = size_t(-1);
+  size_t motion = none;
+  std::vector<size_t> axes;
+  std::vector<size_t> resizes;
+  auto same_axis = [](const SDL_Event& a, const SDL_Event& b) {
+    return a.type == b.type && a.jaxis.which == b.jaxis.which && a.jaxis.axis == b.jaxis.axis;
+  };
+  auto same_resize = [](const SDL_Event& a, const SDL_Event& b) {
+    return a.window.windowID == b.window.windowID && a.window.event == b.window.event;
+  };
+
+  size_t out = 0;
+  for ( size_t in = 0; in < events.size(); ++in ) {
+    const SDL_Event& event = events[in];
+    switch ( event.type ) {
+    case SDL_MOUSEMOTION:
+      if ( motion != none && events[motion].motion.which == event.motion.which ) {
+	SDL_MouseMotionEvent& merged = events[motion].motion;
+	int xrel = merged.xrel + event.motion.xrel;
+	int yrel = merged.yrel + event.motion.yrel;
+	merged = event.motion;
+	merged.xrel = xrel;
+	merged.yrel = yrel;
+	continue;
+      }
+      motion = out;
+      break;
+    case SDL_MOUSEBUTTONDOWN: case SDL_MOUSEBUTTONUP: case SDL_MOUSEWHEEL:
+      motion = none;
+      break;
+    case SDL_JOYAXISMOTION: case SDL_CONTROLLERAXISMOTION: {
+      auto found = std::find_if( axes.begin(), axes.end(), [&](size_t i) { return same_axis( events[i], event ); } );
+      if ( found != axes.end() ) {
+	events[*found] = event;
+	continue;
+      }
+      axes.push_back( out );
+      break;
+    }
+    case SDL_WINDOWEVENT:
+      if ( event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED || event.window.event == SDL_WINDOWEVENT_RESIZED ) {
+	auto found = std::find_if( resizes.begin(), resizes.end(), [&](size_t i) { return same_resize( events[i], event ); } );
+	if ( found != resizes.end() ) {
+	  events[*found] = event;
+	  continue;
+	}
+	resizes.push_back( out );
+      }
+      break;
+    default:
+      break;
+    }
+    if ( out != in )
+      events[out] = event;
+    ++out;
+  }
+  size_t merged = events.size() - out;
+  events.resize( out );
+  return merged;
+}
+
+
+
+const Uint8*
+SbEventSource::keyboard_state()
+{
+  const Uint8* keys = SbGameContext::current().replay_keys;
+  return keys ? keys : SDL_GetKeyboardState(nullptr);
+}
+
+
+
+void
+SbEventSource::flush()
+{
+  if ( !buffer_.empty() )
+    SDL_RWwrite( file_, buffer_.data(), buffer_.size(), 1 );
+  buffer_.clear();
+}
+
+
+
+void
+SbEventSource::write_frame()
+{
+  if ( frame_ == 0 )   // nothing to write before the first frame
+    return;
+  // changes of the keyboard state seen while the frame's events were handled
+  const Uint8* state = SDL_GetKeyboardState(nullptr);
+  std::vector<uint32_t> changed;
+  for ( uint32_t scancode = 0; scancode < keys_.size(); ++scancode ) {
+    if ( bool(state[scancode]) != bool(keys_[scancode]) ) {
+      changed.push_back( scancode );
+      keys_[scancode] = state[scancode];
+    }
+  }
+  write_unsigned( changed.size() );
+  for ( auto scancode: changed )
+    write_unsigned( scancode );
+  write_unsigned( frame_events_.size() );
+  for ( auto& event: frame_events_ )
+    write_event( event );
+  frame_events_.clear();
+}
+
+
+
+void
+SbEventSource::write_event(const SDL_Event& event)
+{
+  write_unsigned( event.type );
+  switch ( event.type ) {
+  case SDL_KEYDOWN: case SDL_KEYUP:
+    write_signed( event.key.keysym.sym );
+    write_unsigned( event.key.keysym.scancode );
+    write_unsigned( event.key.keysym.mod );
+    write_unsigned( event.key.repeat );
+    break;
+  case SDL_MOUSEMOTION:
+    write_unsigned( event.motion.state );
+    write_signed( event.motion.x );
+    write_signed( event.motion.y );
+    write_signed( event.motion.xrel );
+    write_signed( event.motion.yrel );
+    break;
+  case SDL_MOUSEBUTTONDOWN: case SDL_MOUSEBUTTONUP:
+    write_unsigned( event.button.button );
+    write_unsigned( event.button.clicks );
+    write_signed( event.button.x );
+    write_signed( event.button.y );
+    break;
+  case SDL_JOYAXISMOTION: case SDL_CONTROLLERAXISMOTION:
+    write_signed( event.jaxis.which );
+    write_unsigned( event.jaxis.axis );
+    write_signed( event.jaxis.value );
+    break;
+  case SDL_JOYBUTTONDOWN: case SDL_JOYBUTTONUP:
+  case SDL_CONTROLLERBUTTONDOWN: case SDL_CONTROLLERBUTTONUP:
+    write_signed( event.cbutton.which );
+    write_unsigned( event.cbutton.button );
+    break;
+  case SDL_WINDOWEVENT:
+    write_unsigned( event.window.event );
+    write_signed( event.window.data1 );
+    write_signed( event.window.data2 );
+    break;
+  default:  // SDL_QUIT, and events the games do not handle: type only
+    break;
+  }
+}
+
+
+
+bool
+SbEventSource::read_event(SDL_Event& event)
+{
+  std::memset( &event, 0, sizeof(event) );
+  event.type = read_unsigned();
+  event.common.timestamp = time_;
+  switch ( event.type ) {
+  case SDL_KEYDOWN: case SDL_KEYUP:
+    event.key.keysym.sym = read_signed();
+    event.key.keysym.scancode = SDL_Scancode( read_unsigned() );
+    event.key.keysym.mod = read_unsigned();
+    event.key.repeat = read_unsigned();
+    event.key.state = ( event.type == SDL_KEYDOWN ) ? SDL_PRESSED : SDL_RELEASED;
+    break;
+  case SDL_MOUSEMOTION:
+    event.motion.state = read_unsigned();
+    event.motion.x = read_signed();
+    event.motion.y = read_signed();
+    event.motion.xrel = read_signed();
+    event.motion.yrel = read_signed();
+    break;
+  case SDL_MOUSEBUTTONDOWN: case SDL_MOUSEBUTTONUP:
+    event.button.button = read_unsigned();
+    event.button.clicks = read_unsigned();
+    event.button.x = read_signed();
+    event.button.y = read_signed();
+    event.button.state = ( event.type == SDL_MOUSEBUTTONDOWN ) ? SDL_PRESSED : SDL_RELEASED;
+    break;
+  case SDL_JOYAXISMOTION: case SDL_CONTROLLERAXISMOTION:
+    event.jaxis.which = read_signed();
+    event.jaxis.axis = read_unsigned();
+    event.jaxis.value = read_signed();
+    break;
+  case SDL_JOYBUTTONDOWN: case SDL_JOYBUTTONUP:
+  case SDL_CONTROLLERBUTTONDOWN: case SDL_CONTROLLERBUTTONUP:
+    event.cbutton.which = read_signed();
+    event.cbutton.button = read_unsigned();
+    event.cbutton.state = ( event.type == SDL_JOYBUTTONDOWN || event.type == SDL_CONTROLLERBUTTONDOWN ) ? SDL_PRESSED : SDL_RELEASED;
+    break;
+  case SDL_WINDOWEVENT:
+    event.window.event = read_unsigned();
+    event.window.data1 = read_signed();
+    event.window.data2 = read_signed();
+    break;
+  case SDL_QUIT:
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+
+
+void
+SbEventSource::write_unsigned(uint64_t value)
+{
+  while ( value >= 0x80 ) {
+    buffer_.push_back( Uint8(value) | 0x80 );
+    value >>= 7;
+  }
+  buffer_.push_back( Uint8(value) );
+}
+
+
+
+uint64_t
+SbEventSource::read_unsigned()
+{
+  uint64_t value = 0;
+  for ( int shift = 0; shift < 64; shift += 7 ) {
+    if ( position_ >= buffer_.size() )
+      throw std::runtime_error("[SbEventSource::read_unsigned] Error: unexpected end of " + filename_ );
+    Uint8 byte = buffer_[position_++];
+    value |= uint64_t(byte & 0x7f) << shift;
+    if ( !(byte & 0x80) )
+      return value;
+  }
+  throw std::runtime_error("[SbEventSource::read_unsigned] Error: bad varint in " + filename_ );
+}
@@ -0,0 +1,106 @@
+/*! \file SbEventSource.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBEVENTSOURCE_H
+#define SBEVENTSOURCE_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+
+/*! Supplies the SDL_Events consumed by a game loop. By default it just polls SDL. 
+  record() additionally writes every frame's time, keyboard state changes and events to a file, replay() feeds a recording back frame by frame, as fast as the loop runs, and sends SDL_QUIT at the end.
+  script() instead asks a function for every frame's keyboard state and events, e.g. to drive headless sessions of an SbBatchRunner, and advances the clock by a fixed step per frame.
+  All three freeze the SbTimer clock at the frame start time, so all movement computed from timers is the same in the recording and its replay.
+  Unless set_coalescing(false), begin_frame() drains the SDL queue and coalesce()s it, so a burst of mouse or stick motion or a live window resize reaches the game as one event per frame. Recordings hold the coalesced events.
+
+  File format, all numbers LEB128 varints, signed ones zigzag encoded:
+  header: "SBRP", version, start time
+  per frame (the frame index is the position in the file): time since previous frame, number of changed scancodes, the scancodes, number of events, the events (type followed by its fields).
+ */
+class SbGameContext;
+
+
+class SbEventSource
+{
+ public:
+  /*! Called at the start of every frame with the frame index, the keyboard state to change in place and an empty list to add events to. Returning false ends the script, the next poll() gets SDL_QUIT.
+   */
+  typedef std::function<bool(uint64_t frame, Uint8* keys, std::vector<SDL_Event>& events)> Script;
+
+  SbEventSource() = default;
+  SbEventSource(const SbEventSource&) = delete;
+  SbEventSource& operator=(const SbEventSource&) = delete;
+  ~SbEventSource();
+
+  /*! Call once at the start of every frame, before poll().
+   */
+  void begin_frame();
+  bool poll(SDL_Event& event);
+  void record(const std::string& filename);
+  void replay(const std::string& filename);
+  void script(Script script, Uint32 frame_ms = 16);
+  bool replaying() const { return mode_ == Mode::replay; }
+  uint64_t frame() const { return frame_; }
+  void set_coalescing(bool on) { coalescing_ = on; }
+  //! events merged into others since the start
+  uint64_t n_coalesced() const { return n_coalesced_; }
+  std::ostream& print_statistics(std::ostream& os);
+
+  /*! Use instead of SDL_GetKeyboardState, returns the recorded or scripted state during replay or script in the current SbGameContext.
+   */
+  static const Uint8* keyboard_state();
+
+  /*! Merge high-rate events in place and return how many were merged away: consecutive mouse motion of the same mouse into one with the summed xrel/yrel and the last position, unless a mouse button or wheel event comes in between; stick motion to the last value of each axis; window resizes to the final size. The merged event takes the place of the first one, all other events keep their order.
+   */
+  static size_t coalesce(std::vector<SDL_Event>& events);
+
+ private:
+  enum class Mode { live, record, replay, script };
+  
+  //! live and record: fill queue_ from SDL for this frame
+  void drain();
+  void flush();
+  void write_frame();
+  void write_event(const SDL_Event& event);
+  void write_unsigned(uint64_t value);
+  void write_signed(int64_t value) { write_unsigned( (uint64_t(value) << 1) ^ uint64_t(value >> 63) ); }
+  bool read_event(SDL_Event& event);
+  uint64_t read_unsigned();
+  int64_t read_signed() { uint64_t value = read_unsigned(); return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+  Mode mode_ = Mode::live;
+  std::string filename_;
+  SDL_RWops* file_ = nullptr;
+  //! record: encoded data not yet written, replay: the whole recording
+  std::vector<Uint8> buffer_;
+  size_t position_ = 0;
+  //! record: the events of the current frame, written at the start of the next one
+  std::vector<SDL_Event> frame_events_;
+  //! replay: events of the current frame not yet delivered
+  uint64_t pending_events_ = 0;
+  std::array<Uint8, SDL_NUM_SCANCODES> keys_ = {{}};
+  Uint32 time_ = 0;
+  uint64_t frame_ = 0;
+  bool quit_sent_ = false;
+  bool coalescing_ = true;
+  //! live and record with coalescing, script: this frame's events, next_ is the next one to deliver
+  std::vector<SDL_Event> queue_;
+  size_t next_ = 0;
+  uint64_t n_coalesced_ = 0;
+  Uint64 start_counter_ = 0;
+  Script script_;
+  Uint32 frame_ms_ = 16;
+  //! replay and script: the context whose keyboard state is keys_
+  SbGameContext* context_ = nullptr;
+};
+
+
+#endif  // SBEVENTSOURCE_H
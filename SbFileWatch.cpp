@@ -0,0 +1,59 @@
+/*! \file SbFileWatch.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "SbFileWatch.h"
+
+
+SbFileWatch::SbFileWatch(const std::string& filename)
+  : filename_(filename)
+{
+  size_t slash = filename.find_last_of('/');
+  std::string directory = ( slash == std::string::npos ) ? "." : filename.substr( 0, std::max<size_t>( slash, 1 ) );
+  basename_ = ( slash == std::string::npos ) ? filename : filename.substr( slash + 1 );
+
+  fd_ = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+  if ( fd_ < 0 )
+    throw std::runtime_error("[SbFileWatch::SbFileWatch] Error: inotify_init1: " + std::string( std::strerror(errno) ) );
+  if ( inotify_add_watch( fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) < 0 ) {
+    std::string error = std::strerror(errno);
+    close(fd_);
+    throw std::runtime_error("[SbFileWatch::SbFileWatch] Error: Couldn't watch " + directory + ": " + error );
+  }
+}
+
+
+
+SbFileWatch::~SbFileWatch()
+{
+  if ( fd_ >= 0 )
+    close(fd_);
+}
+
+
+
+bool
+SbFileWatch::changed()
+{
+  bool result = false;
+  alignas(struct inotify_event) char buffer[4096];
+  ssize_t length;
+  while ( ( length = read( fd_, buffer, sizeof(buffer) ) ) > 0 ) {
+    for ( char* position = buffer; position < buffer + length; ) {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(position);
+      if ( event->len > 0 && basename_ == event->name )
+	result = true;
+      position += sizeof(struct inotify_event) + event->len;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,35 @@
+/*! \file SbFileWatch.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBFILEWATCH_H
+#define SBFILEWATCH_H
+
+#include <string>
+
+
+/*! Notices when a file is rewritten, using inotify.
+  Watches the directory of the file rather than the file itself, so that a file replaced by renaming a new one over it (as SbLevelFile::write does) is still followed. changed() does not block, call it once per frame.
+ */
+class SbFileWatch
+{
+ public:
+  SbFileWatch(const std::string& filename);
+  SbFileWatch(const SbFileWatch&) = delete;
+  SbFileWatch& operator=(const SbFileWatch&) = delete;
+  ~SbFileWatch();
+
+  /*! True if the file was written or replaced since the last call.
+   */
+  bool changed();
+  const std::string& filename() const { return filename_; }
+
+ private:
+  std::string filename_;
+  std::string basename_;
+  int fd_ = -1;
+};
+
+
+#endif  // SBFILEWATCH_H
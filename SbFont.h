@@ -17,6 +17,7 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "SbResourcePack.h"
 
 
 class SbFont
@@ -26,7 +27,8 @@ class SbFont
   
   SbFont() {}
   SbFont(std::string fontfile, int fontsize) {
-    TTF_Font* tmp_font = TTF_OpenFont(fontfile.c_str(), fontsize);
+    // out of the resource pack if one is mounted
+    TTF_Font* tmp_font = TTF_OpenFontRW( SbResourcePack::open(fontfile), 1, fontsize );
     if ( !tmp_font )
       throw std::runtime_error( "TTF_OpenFont: " + std::string( TTF_GetError() ) );
     font_ = handle(tmp_font, delete_font );
@@ -0,0 +1,108 @@
+/*! \file SbFrameWatchdog.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+#include "SbFrameWatchdog.h"
+
+
+void
+SbFrameWatchdog::begin_frame()
+{
+  if ( budget_ms_ <= 0 )
+    return;
+  if ( frequency_ == 0 )
+    frequency_ = SDL_GetPerformanceFrequency();
+  current_ = ( current_ + 1 ) % history;
+  FrameRecord& frame = frames_[current_];
+  frame.number = ++frame_number_;
+  frame.n_phases = 0;
+  frame.start = SDL_GetPerformanceCounter();
+  frame.end = frame.start;
+}
+
+
+
+void
+SbFrameWatchdog::phase(const char* name)
+{
+  if ( budget_ms_ <= 0 )
+    return;
+  FrameRecord& frame = frames_[current_];
+  if ( frame.n_phases == max_phases )
+    return;
+  frame.names[frame.n_phases] = name;
+  frame.ends[frame.n_phases] = SDL_GetPerformanceCounter();
+  ++frame.n_phases;
+}
+
+
+
+void
+SbFrameWatchdog::end_frame()
+{
+  if ( budget_ms_ <= 0 )
+    return;
+  FrameRecord& frame = frames_[current_];
+  frame.end = SDL_GetPerformanceCounter();
+  if ( milliseconds( frame.end - frame.start ) > budget_ms_ )
+    log_hitch();
+}
+
+
+
+void
+SbFrameWatchdog::log_hitch()
+{
+  ++hitches_;
+  std::string text;
+  std::ostringstream header;
+  header << "hitch, budget " << budget_ms_ << " ms:\n";
+  text += header.str();
+  write_frame( text, frames_[current_] );
+  text += "  previous frames:\n";
+  for ( size_t i = 1; i < history; ++i ) {
+    const FrameRecord& frame = frames_[ ( current_ + history - i ) % history ];
+    if ( frame.number == 0 || frame.number >= frames_[current_].number )
+      break;
+    text += "  ";
+    write_frame( text, frame );
+  }
+
+  SDL_RWops* file = SDL_RWFromFile( log_file_.c_str(), "ab" );
+  if ( file && SDL_RWsize( file ) + Sint64(text.size()) > Sint64(max_log_bytes_) ) {
+    SDL_RWclose( file );
+    std::string old = log_file_ + ".1";
+    std::remove( old.c_str() );
+    std::rename( log_file_.c_str(), old.c_str() );
+    file = SDL_RWFromFile( log_file_.c_str(), "wb" );
+  }
+  if ( !file ) {
+    std::cerr << "[SbFrameWatchdog::log_hitch] Couldn't open " << log_file_ << ": " << SDL_GetError() << std::endl;
+    return;
+  }
+  SDL_RWwrite( file, text.data(), text.size(), 1 );
+  SDL_RWclose( file );
+}
+
+
+
+void
+SbFrameWatchdog::write_frame(std::string& text, const FrameRecord& frame)
+{
+  std::ostringstream strstr;
+  strstr << std::fixed << std::setprecision(2)
+	 << "frame " << frame.number << ": " << milliseconds( frame.end - frame.start ) << " ms";
+  Uint64 previous = frame.start;
+  for ( uint32_t i = 0; i < frame.n_phases; ++i ) {
+    strstr << "  " << frame.names[i] << " " << milliseconds( frame.ends[i] - previous );
+    previous = frame.ends[i];
+  }
+  strstr << "\n";
+  text += strstr.str();
+}
@@ -0,0 +1,62 @@
+/*! \file SbFrameWatchdog.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBFRAMEWATCHDOG_H
+#define SBFRAMEWATCHDOG_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+
+/*! Times the phases of every frame and, when a frame takes longer than the budget, appends the frame and the frames before it to a log file.
+  The game loop calls begin_frame(), phase("name") at the end of each phase and end_frame(). Without a hitch this costs a performance counter read per call, nothing is allocated or written.
+  The log is bounded: when it grows beyond the size limit it is moved to <log>.1 and a new one is started.
+ */
+class SbFrameWatchdog
+{
+ public:
+  static const size_t max_phases = 8;
+  static const size_t history = 8;
+
+  void begin_frame();
+  //! name must outlive the watchdog, use string literals
+  void phase(const char* name);
+  void end_frame();
+  /*! budget in ms, 0 disables the watchdog
+   */
+  void set_budget(double ms) { budget_ms_ = ms; }
+  void set_log(const std::string& filename, uint64_t max_bytes = 1 << 20) { log_file_ = filename; max_log_bytes_ = max_bytes; }
+  uint64_t hitches() const { return hitches_; }
+  
+ private:
+  struct FrameRecord
+  {
+    uint64_t number = 0;
+    Uint64 start = 0;
+    Uint64 end = 0;
+    uint32_t n_phases = 0;
+    std::array<const char*, max_phases> names;
+    std::array<Uint64, max_phases> ends;
+  };
+
+  double milliseconds(Uint64 ticks) const { return 1000.0 * ticks / frequency_; }
+  void log_hitch();
+  void write_frame(std::string& text, const FrameRecord& frame);
+
+  std::array<FrameRecord, history> frames_;
+  size_t current_ = 0;
+  uint64_t frame_number_ = 0;
+  uint64_t hitches_ = 0;
+  double budget_ms_ = 0;
+  Uint64 frequency_ = 0;
+  std::string log_file_ = "hitches.log";
+  uint64_t max_log_bytes_ = 1 << 20;
+};
+
+
+#endif  // SBFRAMEWATCHDOG_H
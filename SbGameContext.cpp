@@ -0,0 +1,27 @@
+/*! \file SbGameContext.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include "SbGameContext.h"
+
+
+thread_local SbGameContext* SbGameContext::current_ = nullptr;
+SbGameContext SbGameContext::default_;
+
+
+SbGameContext::~SbGameContext()
+{
+  if ( current_ == this )
+    current_ = nullptr;
+}
+
+
+
+SbGameContext*
+SbGameContext::make_current(SbGameContext* context)
+{
+  SbGameContext* previous = current_;
+  current_ = context;
+  return previous;
+}
@@ -0,0 +1,55 @@
+/*! \file SbGameContext.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBGAMECONTEXT_H
+#define SBGAMECONTEXT_H
+
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+#include "SbRenderStats.h"
+
+class SbWindow;
+class SbRenderThread;
+
+
+/*! The state of one game instance that the objects, timers and renderer wrappers reach without being handed it: the window, the clock, the keyboard state of a replay or script and the render counters.
+  Every thread has a current context. A game makes its own current when it is constructed and at the start of every frame, so several instances can live in one process and run on different threads, one thread per instance at a time. Threads that never call make_current() share a default context.
+ */
+class SbGameContext
+{
+ public:
+  SbGameContext() = default;
+  SbGameContext(const SbGameContext&) = delete;
+  SbGameContext& operator=(const SbGameContext&) = delete;
+  //! the calling thread falls back to the default context if this was its current one
+  ~SbGameContext();
+
+  //! the window SbObjects render to
+  SbWindow* window = nullptr;
+  //! SbTimer::now() returns fixed_time while fixed_clock is set
+  bool fixed_clock = false;
+  Uint32 fixed_time = 0;
+  //! keyboard state of a replay or script, nullptr: SDL's
+  const Uint8* replay_keys = nullptr;
+  //! SbRenderStats of the frame being drawn and of the last one
+  SbRenderCounters render_current;
+  SbRenderCounters render_last;
+  uint64_t frames = 0;
+  SbRenderThread* render_thread = nullptr;
+
+  static SbGameContext& current() { return current_ ? *current_ : default_; }
+  /*! Make context the current one of the calling thread, nullptr for the default. Returns the one current before.
+   */
+  static SbGameContext* make_current(SbGameContext* context);
+
+ private:
+  static thread_local SbGameContext* current_;
+  static SbGameContext default_;
+};
+
+
+#endif  // SBGAMECONTEXT_H
@@ -20,13 +20,12 @@ author: Ulrike Hager
 #include "SbWindow.h"
 #include "SbObject.h"
 #include "SbFont.h"
+#include "SbRenderStats.h"
+#include "SbOptions.h"
 
 #include "SbHalfPong.h"
 
 
-//SbWindow* SbObject::window;
-
-
 /*! Paddle implementation
  */
 Paddle::Paddle( const SbDimension* ref )
@@ -37,7 +36,7 @@ Paddle::Paddle( const SbDimension* ref )
   velocity_ = 1.0/1200.0;
   SDL_Color color = {210, 160, 10, 0};
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color );
+  texture_->from_rectangle( window()->renderer(), bounding_rect_.w, bounding_rect_.h, color );
   name_ = "paddle";
 }
 
@@ -49,7 +48,7 @@ Paddle::Paddle(SDL_Rect rect, const SbDimension* ref)
   velocity_ = 1.0/1200.0;
   SDL_Color color = {210, 160, 10, 0};
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color );
+  texture_->from_rectangle( window()->renderer(), bounding_rect_.w, bounding_rect_.h, color );
   name_ = "paddle";
 }
 
@@ -73,9 +72,7 @@ Paddle::handle_event(const SDL_Event& event)
   }
   else if (event.type == SDL_MOUSEBUTTONDOWN)
     {
-      int mouse_x = -1, mouse_y = -1;
-      SDL_GetMouseState( &mouse_x, &mouse_y );
-      is_inside( mouse_x, mouse_y );
+      is_inside( event.button.x, event.button.y );
 #ifdef DEBUG
       std::cout << "[Paddle::handle_event] mouse click is " << ( has_mouse()? "inside" : "outside" ) << std::endl;
 #endif // DEBUG
@@ -98,9 +95,9 @@ int
 Paddle::move()
 {
   Uint32 deltaT = timer_.get_time();
-  int velocity = (int)( window->height() * velocity_y_ * deltaT); 
+  int velocity = (int)( window()->height() * velocity_y_ * deltaT); 
   bounding_rect_.y += velocity;
-  if( ( bounding_rect_.y < 0 ) || ( bounding_rect_.y + bounding_rect_.h > window->height() ) ) {
+  if( ( bounding_rect_.y < 0 ) || ( bounding_rect_.y + bounding_rect_.h > window()->height() ) ) {
     bounding_rect_.y -= velocity;
   }
   move_bounding_box();
@@ -127,7 +124,7 @@ Ball::Ball(const SbDimension* ref)
   velocity_x_ = 1.0/1500.0;
   velocity_ = 1.0/1500.0;
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_file(window->renderer(), "resources/ball.png", bounding_rect_.w, bounding_rect_.h );
+  texture_->from_file(window()->renderer(), "resources/ball.png", bounding_rect_.w, bounding_rect_.h );
   name_ = "ball";
 }
 
@@ -182,11 +179,11 @@ Ball::move(const SDL_Rect& paddleBox)
     return result;
   }
   Uint32 deltaT = timer_.get_time();
-  int x_velocity = (int)( window->width() * velocity_x_ * deltaT );
-  int y_velocity = (int)( window->height() * velocity_y_ * deltaT );  
+  int x_velocity = (int)( window()->width() * velocity_x_ * deltaT );
+  int y_velocity = (int)( window()->height() * velocity_y_ * deltaT );  
   bounding_rect_.y += y_velocity;
   bounding_rect_.x += x_velocity;
-  if ( bounding_rect_.x + bounding_rect_.w >= window->width() ) {
+  if ( bounding_rect_.x + bounding_rect_.w >= window()->width() ) {
     goal_ = 1;
     center_in_front(paddleBox);
     return goal_;
@@ -225,7 +222,7 @@ Ball::move(const SDL_Rect& paddleBox)
   if ( ( y_hit_bottom && in_xrange )  || bounding_rect_.y <= 0 ) {
     if ( velocity_y_ < 0 ) velocity_y_ *= -1;
   }
-  else if ( ( y_hit_top && in_xrange )|| ( bounding_rect_.y + bounding_rect_.h >= window->height() ) ) {
+  else if ( ( y_hit_top && in_xrange )|| ( bounding_rect_.y + bounding_rect_.h >= window()->height() ) ) {
     if ( velocity_y_ > 0 ) velocity_y_ *= -1;
   }
  
@@ -267,20 +264,14 @@ Ball::reset()
 
 
 
-Uint32
-Ball::resetball(Uint32 interval, void *param )
-{
-  ((Ball*)param)->reset();
-  return(0);
-}
-
-
 /*! GameOver implementation
  */
 GameOver::GameOver(std::shared_ptr<TTF_Font> font, const SbDimension* ref)
   : SbMessage(SbRectangle{0.35,0.58,0.3,0.2}, ref)
 {
   name_ = "gameover" ;
+  layer_ = LAYER_GAMEOVER;
+  tags_ = TAG_GAMEOVER;
   font_ = font;
   set_text("Game Over");
 }
@@ -289,7 +280,8 @@ GameOver::GameOver(std::shared_ptr<TTF_Font> font, const SbDimension* ref)
 
 HalfPong::HalfPong()
 {
-  SbObject::window = &window_ ;
+  SbGameContext::make_current( &context_ );
+  context_.window = &window_;
   SbFont font("resources/FreeSans.ttf", 120 );
   // font_ = std::shared_ptr<TTF_Font>( TTF_OpenFont( "resources/FreeSans.ttf", 120 ), DeleteFont() );
   // if ( !font_.get() )
@@ -298,65 +290,92 @@ HalfPong::HalfPong()
   ball_ = std::unique_ptr<Ball>( new Ball(ref) );
   paddle_ = std::unique_ptr<Paddle>( new Paddle(ref) );
   fps_display_ = std::unique_ptr<SbFpsDisplay>( new SbFpsDisplay( font.font(), SbRectangle{0, 0, 0.06, 0.035}, ref ) );
+  render_stats_ = std::unique_ptr<SbRenderStatsDisplay>( new SbRenderStatsDisplay( font.font(), SbRectangle{0, 0.035, 0.3, 0.035}, ref ) );
   game_over_ = std::unique_ptr<GameOver>( new GameOver( font.font(), ref ) );
   high_score_ = std::unique_ptr<SbHighScore>( new SbHighScore( font.font(), SbRectangle{0.2,0.4,0.6,0.23}, ref ) );
   high_score_->savefile = "halfpong.save";
   high_score_->prefix = "Score:" ;
   high_score_->set_precision(0);
+  high_score_->read_highscores();
+  high_score_->set_layer(LAYER_GAMEOVER);
+  high_score_->set_tags(TAG_GAMEOVER);
   lives_ = std::unique_ptr<SbMessage>( new SbMessage(SbRectangle{0.2, 0.003, 0.13, 0.07}, ref ) );
   score_text_ = std::unique_ptr<SbMessage>( new SbMessage( SbRectangle{0.5, 0.003, 0.13, 0.07}, ref ) );
   lives_->set_font(font.font());
   score_text_->set_font(font.font());
   lives_->set_text( "Lives: " + std::to_string(goal_counter_) );
   score_text_->set_text( "Score: " + std::to_string(score_) );
-  
+  for ( SbObject* hud: std::initializer_list<SbObject*>{ lives_.get(), score_text_.get(), fps_display_.get(), render_stats_.get() } )
+    hud->set_layer(LAYER_HUD);
+
+  objects_.push_back(paddle_.get() );
+  objects_.push_back(ball_.get() );
+  objects_.push_back(lives_.get() );
+  objects_.push_back(score_text_.get() );
+  objects_.push_back(game_over_.get() );
+  objects_.push_back(high_score_.get() );
+  objects_.push_back(fps_display_.get() );
+  objects_.push_back(render_stats_.get() );
+  for ( SbObject* object: objects_ )
+    draw_list_.add( object );
+
+  dispatcher_.subscribe( SDL_QUIT, [this](const SDL_Event&) { quit_ = true; }, this );
+  dispatcher_.subscribe_key( SDLK_ESCAPE, [this](const SDL_Event& event) { if ( event.type == SDL_KEYDOWN ) quit_ = true; }, this );
+  for ( SDL_Keycode key: { SDLK_n, SDLK_SPACE, SDLK_RETURN } )
+    dispatcher_.subscribe_key( key, [this](const SDL_Event& event) { if ( event.type == SDL_KEYDOWN ) new_game(); }, this );
+  dispatcher_.subscribe_key( SDLK_UP, paddle_.get() );
+  dispatcher_.subscribe_key( SDLK_DOWN, paddle_.get() );
+  for ( Uint32 type: { SDL_MOUSEBUTTONDOWN, SDL_MOUSEBUTTONUP, SDL_MOUSEMOTION } )
+    dispatcher_.subscribe( type, paddle_.get() );
+  dispatcher_.subscribe_key( SDLK_f, fps_display_.get() );
+  dispatcher_.subscribe_key( SDLK_r, render_stats_.get() );
 }
 
 
+void
+HalfPong::new_game()
+{
+  goal_counter_ = 3;
+  timers_.cancel( ball_reset_ );
+  ball_->reset();
+  lives_->set_text( "Lives: " + std::to_string(goal_counter_) );
+  score_ = 0;
+  score_text_->set_text( "Score: " + std::to_string(score_) );
+}
+
+
+
 void
 HalfPong::run()
 {
-    std::vector<SbObject*> objects;
-    objects.push_back(paddle_.get() );
-    objects.push_back(ball_.get() );
-    objects.push_back(lives_.get() );
-    objects.push_back(score_text_.get() );
-    objects.push_back(game_over_.get() );
-    objects.push_back(high_score_.get() );
-    objects.push_back(fps_display_.get() );
-
-    SDL_Event event;
-    bool quit = false;
-
-    while (!quit) {
-      while( SDL_PollEvent( &event ) ) {
-	if (event.type == SDL_QUIT) quit = true;
-	else if (event.type == SDL_KEYDOWN ) {
-	  switch ( event.key.keysym.sym ) {
-	  case SDLK_ESCAPE:
-	    quit = true;
-	    break;
-	  case SDLK_n: case SDLK_SPACE: case SDLK_RETURN:
-	    goal_counter_ = 3;
-	    ball_->reset();
-	    lives_->set_text( "Lives: " + std::to_string(goal_counter_) );
-	    score_ = 0;
-	    score_text_->set_text( "Score: " + std::to_string(score_) );
-	    break;
-	  }
-	}
-	if ( window_.handle_event( event ) ) {
-	  std::for_each( objects.begin(), objects.end(),
-			 [] (SbObject* obj) {obj->update_size();} );
-	}
-	std::for_each( objects.begin(), objects.end(),
-		       [event] (SbObject* obj) {obj->handle_event( event );} );
+  while (!quit_)
+    frame();
+}
 
-      }
-            
-      move_objects();
-      render( objects );
+
+
+void
+HalfPong::frame()
+{
+  SDL_Event event;
+
+  SbGameContext::make_current( &context_ );
+  watchdog_.begin_frame();
+  events_.begin_frame();
+  while( events_.poll( event ) ) {
+    if ( window_.handle_event( event ) ) {
+      std::for_each( objects_.begin(), objects_.end(),
+		     [] (SbObject* obj) {obj->update_size();} );
     }
+    dispatcher_.dispatch( event );
+  }
+  watchdog_.phase("events");
+            
+  timers_.update();
+  move_objects();
+  watchdog_.phase("update");
+  render();
+  watchdog_.end_frame();
 }
 
 
@@ -370,7 +389,7 @@ HalfPong::move_objects()
     case 1: 
       --goal_counter_;
       if (goal_counter_ > 0 ) {
-	SDL_AddTimer(1000, Ball::resetball, ball_.get());
+	ball_reset_ = timers_.schedule( 1000, [this]() { ball_->reset(); } );
       }
       else {
 	high_score_->check_highscore( score_, &SbHighScore::higher);
@@ -390,33 +409,47 @@ HalfPong::move_objects()
 
 
 void
-HalfPong::render(std::vector<SbObject*> objects)
+HalfPong::render()
 {
   fps_display_->update();
+  render_stats_->update();
 
   // render
-  SDL_RenderClear( window_.renderer() );
+  SbRenderStats::clear( window_.renderer() );
   
-  std::for_each( objects.begin(), objects.end(),
-		 [](SbObject* obj) {if (obj->name() != "gameover") obj->render(); } );
-
- 
-  if ( goal_counter_ == 0 ) {
-    game_over_->render();
-    high_score_->render();
-  }
-  SDL_RenderPresent( window_.renderer() );
+  uint32_t visible = SB_TAG_DEFAULT;
+  if ( goal_counter_ == 0 )
+    visible |= TAG_GAMEOVER;
+  draw_list_.render( visible );
+  watchdog_.phase("render");
+  SbRenderStats::present( window_.renderer() );
+  watchdog_.phase("present");
 
 }
 
 
 
-int main()
+int main(int argc, char* argv[])
 {
-  sdl_init();
+  SbOptions options;
+  try {
+    for ( int i = 1; i < argc; ++i ) {
+      if ( !options.parse(i, argc, argv) )
+	throw std::runtime_error( "usage: " + std::string(argv[0]) + " " + SbOptions::usage() );
+    }
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    return 1;
+  }
+
+  sdl_init(options.headless);
   try {
     HalfPong halfpong;
+    options.apply( *halfpong.events(), *halfpong.watchdog(), *halfpong.window() );
     halfpong.run();
+    if ( halfpong.events()->replaying() )
+      halfpong.events()->print_statistics(std::cout);
   }
   catch (const std::exception& expt) {
     std::cerr << expt.what() << std::endl;
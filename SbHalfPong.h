@@ -14,7 +14,13 @@ author: Ulrike Hager
 #include <SDL2/SDL_ttf.h>
 
 #include "SbObject.h"
+#include "SbGameContext.h"
 #include "SbMessage.h"
+#include "SbEventSource.h"
+#include "SbFrameWatchdog.h"
+#include "SbDrawList.h"
+#include "SbEventDispatcher.h"
+#include "SbTimerWheel.h"
 
 
 class Ball;
@@ -25,6 +31,12 @@ class Paddle;
 /////  globals /////
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
+//! draw layers, bottom to top
+const int LAYER_GAME = 0;
+const int LAYER_HUD = 1;
+const int LAYER_GAMEOVER = 2;
+//! drawn only once the last life is gone
+const uint32_t TAG_GAMEOVER = 1u << 1;
 
 
 
@@ -52,7 +64,6 @@ public:
   /*! Reset after goal.
    */
   void reset();
-  static Uint32 resetball(Uint32 interval, void *param );
 
   
 private:
@@ -104,21 +115,45 @@ class HalfPong
  public:
   HalfPong();
   void move_objects();
-  void render( std::vector<SbObject*> objects );
+  void render();
   void run();
+  /*! One pass of the game loop: poll events, move, render.
+   */
+  void frame();
+  SbEventSource* events() {return &events_; }
+  SbFrameWatchdog* watchdog() {return &watchdog_; }
+  SbWindow* window() {return &window_; }
+  SbGameContext* context() {return &context_; }
   
  private:
+  //! reset lives, score and ball
+  void new_game();
+  //! first, so that it outlives everything that draws or times with it
+  SbGameContext context_;
   SbWindow window_{"Half-Pong", SCREEN_WIDTH, SCREEN_HEIGHT};
+  SbEventSource events_;
+  SbFrameWatchdog watchdog_;
+  std::vector<SbObject*> objects_;
+  //! objects_ by layer, built once in the constructor
+  SbDrawList draw_list_;
+  //! routes each event to the objects that subscribed to it, set up in the constructor
+  SbEventDispatcher dispatcher_;
+  //! delayed work, run on the game loop at the start of the update phase
+  SbTimerWheel timers_;
+  //! puts the ball back in play after a goal
+  SbTimerWheel::Handle ball_reset_ = 0;
   std::unique_ptr<Ball> ball_;
   std::unique_ptr<Paddle> paddle_;
   //  std::shared_ptr<TTF_Font> font_;
   std::unique_ptr<SbFpsDisplay> fps_display_;
+  std::unique_ptr<SbRenderStatsDisplay> render_stats_;
   std::unique_ptr<SbMessage> lives_;
   std::unique_ptr<SbMessage> score_text_;
   std::unique_ptr<GameOver> game_over_;
   std::unique_ptr<SbHighScore> high_score_;
   uint32_t goal_counter_ = 3;
   uint32_t score_ = 0;
+  bool quit_ = false;
 };
 
 #endif  // SBHALFPONG_H
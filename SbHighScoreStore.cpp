@@ -0,0 +1,259 @@
+/*! \file SbHighScoreStore.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#include "SbHighScoreStore.h"
+
+
+const char SbHighScoreStore::magic[4] = {'S', 'b', 'H', 'S'};
+
+namespace {
+  //! records or legacy scores read per SDL_RWread while loading
+  const size_t block_size = 256;
+}
+
+
+
+SbHighScoreStore::SbHighScoreStore(const std::string& filename)
+  : filename_(filename)
+{
+  if ( filename_.empty() )
+    return;
+  load();
+  writer_ = std::thread( &SbHighScoreStore::write_loop, this );
+}
+
+
+
+SbHighScoreStore::~SbHighScoreStore()
+{
+  if ( !writer_.joinable() )
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  writer_.join();
+}
+
+
+
+uint32_t
+SbHighScoreStore::crc(const Record& record)
+{
+  // CRC-32 (IEEE 802.3) of level and score
+  static const std::vector<uint32_t> table = []() {
+    std::vector<uint32_t> result(256);
+    for ( uint32_t i = 0; i < 256; ++i ) {
+      uint32_t c = i;
+      for ( int bit = 0; bit < 8; ++bit )
+	c = ( c & 1 ) ? 0xEDB88320u ^ ( c >> 1 ) : c >> 1;
+      result[i] = c;
+    }
+    return result;
+  }();
+  uint8_t bytes[ 2 * sizeof(uint32_t) ];
+  std::memcpy( bytes, &record.level, sizeof(uint32_t) );
+  std::memcpy( bytes + sizeof(uint32_t), &record.score, sizeof(uint32_t) );
+  uint32_t c = 0xFFFFFFFFu;
+  for ( uint8_t b: bytes )
+    c = table[ ( c ^ b ) & 0xFF ] ^ ( c >> 8 );
+  return c ^ 0xFFFFFFFFu;
+}
+
+
+
+void
+SbHighScoreStore::set(uint32_t level, uint32_t score)
+{
+  if ( level >= max_levels )
+    throw std::runtime_error("[SbHighScoreStore::set] Error: level " + std::to_string(level) + " out of range" );
+  Record record = { level, score, 0 };
+  record.crc = crc(record);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ( level >= scores_.size() )
+      scores_.resize( level + 1, 0 );
+    scores_.at(level) = score;
+    if ( !filename_.empty() )
+      pending_.push_back( record );
+  }
+  wake_.notify_one();
+}
+
+
+
+void
+SbHighScoreStore::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait( lock, [this]() { return pending_.empty() && !compact_pending_ && !writing_; } );
+}
+
+
+
+void
+SbHighScoreStore::load()
+{
+  SDL_RWops* file = SDL_RWFromFile( filename_.c_str(), "rb" );
+  if ( !file )
+    return;
+  Header header;
+  size_t length = SDL_RWread( file, &header, 1, sizeof(header) );
+  if ( length < sizeof(header.magic) || std::memcmp( header.magic, magic, sizeof(magic) ) != 0 ) {
+    uint32_t first = 0;
+    std::memcpy( &first, &header, std::min( length, sizeof(first) ) );
+    if ( length >= sizeof(first) )
+      load_legacy( file, first );
+    SDL_RWclose( file );
+    compact_pending_ = ( length > 0 );
+    return;
+  }
+  if ( length < sizeof(header) || header.version != version ) {
+    SDL_RWclose( file );
+    throw std::runtime_error("[SbHighScoreStore::load] Error: " + filename_ + " has an unknown version" );
+  }
+
+  std::vector<Record> block( block_size );
+  while ( true ) {
+    size_t bytes = SDL_RWread( file, block.data(), 1, block.size() * sizeof(Record) );
+    size_t n_records = bytes / sizeof(Record);
+    for ( size_t i = 0; i < n_records; ++i ) {
+      const Record& record = block.at(i);
+      if ( record.crc != crc(record) ) {
+	compact_pending_ = true;
+	break;
+      }
+      ++journal_records_;
+      if ( record.level >= max_levels )
+	continue;
+      if ( record.level >= scores_.size() )
+	scores_.resize( record.level + 1, 0 );
+      scores_.at(record.level) = record.score;
+    }
+    if ( bytes % sizeof(Record) != 0 )
+      compact_pending_ = true;
+    if ( compact_pending_ || bytes < block.size() * sizeof(Record) )
+      break;
+  }
+  SDL_RWclose( file );
+#ifdef DEBUG
+  std::cout << "[SbHighScoreStore::load] " << filename_ << ": " << journal_records_ << " records, " << scores_.size() << " levels" << std::endl;
+#endif
+}
+
+
+
+void
+SbHighScoreStore::load_legacy(SDL_RWops* file, uint32_t first)
+{
+  // count, then one score per level; the count is not trusted beyond the file size
+  Sint64 size = SDL_RWsize( file );
+  uint64_t available = ( size > Sint64(sizeof(uint32_t)) ) ? ( size - sizeof(uint32_t) ) / sizeof(uint32_t) : 0;
+  uint32_t count = std::min<uint64_t>( std::min<uint64_t>( first, available ), max_levels );
+  SDL_RWseek( file, sizeof(uint32_t), RW_SEEK_SET );
+  std::vector<uint32_t> block( block_size );
+  while ( scores_.size() < count ) {
+    size_t wanted = std::min<size_t>( block.size(), count - scores_.size() );
+    size_t n_read = SDL_RWread( file, block.data(), sizeof(uint32_t), wanted );
+    scores_.insert( scores_.end(), block.begin(), block.begin() + n_read );
+    if ( n_read < wanted )
+      break;
+  }
+}
+
+
+
+void
+SbHighScoreStore::write_loop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while ( true ) {
+    wake_.wait( lock, [this]() { return stop_ || compact_pending_ || !pending_.empty(); } );
+    if ( pending_.empty() && !compact_pending_ )
+      break;
+    std::vector<Record> records;
+    records.swap( pending_ );
+    bool compacting = compact_pending_ || journal_records_ + records.size() > scores_.size() + compact_after;
+    std::vector<uint32_t> scores;
+    if ( compacting )
+      scores = scores_;
+    compact_pending_ = false;
+    writing_ = true;
+    lock.unlock();
+    try {
+      if ( compacting )
+	compact( scores );
+      else
+	append( records );
+    }
+    catch ( const std::exception& e ) {
+      // nobody to throw to on this thread, the scores stay in memory and the next write tries again
+      std::cerr << e.what() << std::endl;
+    }
+    lock.lock();
+    writing_ = false;
+    idle_.notify_all();
+  }
+}
+
+
+
+void
+SbHighScoreStore::append(const std::vector<Record>& records)
+{
+  SDL_RWops* file = SDL_RWFromFile( filename_.c_str(), "ab" );
+  if ( !file )
+    throw std::runtime_error("[SbHighScoreStore::append] Error: Couldn't open file " + filename_ + ":\n" + SDL_GetError() );
+  if ( SDL_RWsize( file ) == 0 ) {
+    Header header;
+    std::memcpy( header.magic, magic, sizeof(magic) );
+    header.version = version;
+    SDL_RWwrite( file, &header, sizeof(header), 1 );
+  }
+  size_t written = SDL_RWwrite( file, records.data(), sizeof(Record), records.size() );
+  SDL_RWclose( file );
+  journal_records_ += written;
+  if ( written != records.size() )
+    throw std::runtime_error("[SbHighScoreStore::append] Error: Couldn't write " + filename_ );
+}
+
+
+
+void
+SbHighScoreStore::compact(const std::vector<uint32_t>& scores)
+{
+  std::vector<Record> records;
+  for ( uint32_t level = 0; level < scores.size(); ++level ) {
+    if ( scores.at(level) == 0 )
+      continue;
+    Record record = { level, scores.at(level), 0 };
+    record.crc = crc(record);
+    records.push_back( record );
+  }
+  // written next to the journal and renamed over it, a crash leaves either the old or the new file
+  std::string temporary = filename_ + ".tmp";
+  SDL_RWops* file = SDL_RWFromFile( temporary.c_str(), "wb" );
+  if ( !file )
+    throw std::runtime_error("[SbHighScoreStore::compact] Error: Couldn't open file " + temporary + ":\n" + SDL_GetError() );
+  Header header;
+  std::memcpy( header.magic, magic, sizeof(magic) );
+  header.version = version;
+  bool good = ( SDL_RWwrite( file, &header, sizeof(header), 1 ) == 1 );
+  if ( !records.empty() )
+    good = good && ( SDL_RWwrite( file, records.data(), sizeof(Record), records.size() ) == records.size() );
+  SDL_RWclose( file );
+  if ( !good || std::rename( temporary.c_str(), filename_.c_str() ) != 0 ) {
+    std::remove( temporary.c_str() );
+    throw std::runtime_error("[SbHighScoreStore::compact] Error: Couldn't write " + filename_ );
+  }
+  journal_records_ = records.size();
+}
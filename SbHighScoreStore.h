@@ -0,0 +1,84 @@
+/*! \file SbHighScoreStore.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBHIGHSCORESTORE_H
+#define SBHIGHSCORESTORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <SDL2/SDL.h>
+
+
+/*! Keeps the highscores of a game, one per level, in a journal file written by a background thread.
+  The file starts with a header (magic, version) followed by records of level, score and a CRC32 of both. set() only queues a record, the writer thread appends everything queued in one write, so a new record never waits for the disk. When the journal holds more than compact_after records beyond one per level it is rewritten with just the current scores, to a temporary file that is renamed over the journal.
+  An empty filename keeps the scores in memory only.
+  Loading reads the records in blocks of fixed size and stops at the first one that fails its CRC (a write torn by a crash), a damaged tail is cut off by compacting. Levels above max_levels are ignored, so a corrupt file can not make the store allocate much. Files in the old format (count followed by the scores) are read the same way and converted.
+ */
+class SbHighScoreStore
+{
+ public:
+  static const uint32_t version = 1;
+  static const uint32_t max_levels = 1 << 16;
+
+  SbHighScoreStore(const std::string& filename);
+  SbHighScoreStore(const SbHighScoreStore&) = delete;
+  SbHighScoreStore& operator=(const SbHighScoreStore&) = delete;
+  //! writes what is still queued
+  ~SbHighScoreStore();
+
+  /*! Score of every level, 0 for levels without a score.
+   */
+  const std::vector<uint32_t>& scores() const { return scores_; }
+  /*! Records score for level and queues it for writing, does not block on the disk.
+   */
+  void set(uint32_t level, uint32_t score);
+  /*! Blocks until everything set so far is written.
+   */
+  void flush();
+  const std::string& filename() const { return filename_; }
+
+  //! journal records beyond one per level before compacting
+  uint32_t compact_after = 64;
+
+ private:
+  struct Record {
+    uint32_t level;
+    uint32_t score;
+    uint32_t crc;
+  };
+  struct Header {
+    char magic[4];
+    uint32_t version;
+  };
+  static const char magic[4];
+
+  static uint32_t crc(const Record& record);
+  void load();
+  void load_legacy(SDL_RWops* file, uint32_t first);
+  void write_loop();
+  void append(const std::vector<Record>& records);
+  void compact(const std::vector<uint32_t>& scores);
+
+  std::string filename_;
+  //! scores as set, read by the writer thread when compacting
+  std::vector<uint32_t> scores_;
+  //! records in the journal file
+  uint64_t journal_records_ = 0;
+  bool compact_pending_ = false;
+  std::vector<Record> pending_;
+  bool writing_ = false;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::thread writer_;
+};
+
+
+#endif  // SBHIGHSCORESTORE_H
@@ -0,0 +1,127 @@
+/*! \file SbInput.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "SbEventSource.h"
+
+#include "SbInput.h"
+
+
+SbInput::SbInput()
+{
+  bind_key( SDL_SCANCODE_UP, SbAction::up );
+  bind_key( SDL_SCANCODE_DOWN, SbAction::down );
+  bind_key( SDL_SCANCODE_LEFT, SbAction::left );
+  bind_key( SDL_SCANCODE_RIGHT, SbAction::right );
+  bind_key( SDL_SCANCODE_SPACE, SbAction::jump );
+  bind_key( SDL_SCANCODE_ESCAPE, SbAction::quit );
+  bind_key( SDL_SCANCODE_BACKSPACE, SbAction::rewind );
+  bind_button( SDL_CONTROLLER_BUTTON_DPAD_UP, SbAction::up );
+  bind_button( SDL_CONTROLLER_BUTTON_DPAD_DOWN, SbAction::down );
+  bind_button( SDL_CONTROLLER_BUTTON_DPAD_LEFT, SbAction::left );
+  bind_button( SDL_CONTROLLER_BUTTON_DPAD_RIGHT, SbAction::right );
+  bind_button( SDL_CONTROLLER_BUTTON_A, SbAction::jump );
+  bind_button( SDL_CONTROLLER_BUTTON_B, SbAction::quit );
+}
+
+
+
+void
+SbInput::bind_key(SDL_Scancode key, SbAction action)
+{
+  if ( key_actions_.at(key) == 0 )
+    bound_keys_.push_back( key );
+  key_actions_[key] |= SbInputState::bit(action);
+}
+
+
+
+void
+SbInput::bind_button(SDL_GameControllerButton button, SbAction action)
+{
+  button_actions_.at(button) |= SbInputState::bit(action);
+}
+
+
+
+void
+SbInput::clear_bindings()
+{
+  key_actions_.fill( 0 );
+  bound_keys_.clear();
+  button_actions_.fill( 0 );
+}
+
+
+
+void
+SbInput::handle_event(const SDL_Event& event)
+{
+  switch ( event.type ) {
+  case SDL_KEYDOWN:
+    if ( event.key.repeat == 0 && event.key.keysym.scancode < SDL_NUM_SCANCODES )
+      pressed_ |= key_actions_[event.key.keysym.scancode];
+    break;
+  case SDL_CONTROLLERBUTTONDOWN:
+    if ( event.cbutton.which == 0 && event.cbutton.button < button_actions_.size() ) {
+      buttons_down_ |= 1u << event.cbutton.button;
+      pressed_ |= button_actions_[event.cbutton.button];
+    }
+    break;
+  case SDL_CONTROLLERBUTTONUP:
+    if ( event.cbutton.which == 0 && event.cbutton.button < button_actions_.size() )
+      buttons_down_ &= ~( 1u << event.cbutton.button );
+    break;
+  case SDL_CONTROLLERAXISMOTION: case SDL_JOYAXISMOTION:
+    if ( event.jaxis.which == 0 ) {
+      if ( event.jaxis.axis == 0 )
+	axis_x_ = event.jaxis.value;
+      else if ( event.jaxis.axis == 1 )
+	axis_y_ = event.jaxis.value;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+
+
+const SbInputState&
+SbInput::sample()
+{
+  uint32_t held = 0;
+  const Uint8* keyboard = SbEventSource::keyboard_state();
+  for ( SDL_Scancode key: bound_keys_ ) {
+    if ( keyboard[key] )
+      held |= key_actions_[key];
+  }
+  for ( uint32_t button = 0; buttons_down_ >> button; ++button ) {
+    if ( ( buttons_down_ >> button ) & 1u )
+      held |= button_actions_[button];
+  }
+
+  uint32_t analog = 0;
+  state_.axis_x = ( std::abs( int(axis_x_) ) > deadzone ) ? std::max( axis_x_ / 32767.0, -1.0 ) : 0;
+  state_.axis_y = ( std::abs( int(axis_y_) ) > deadzone ) ? std::max( axis_y_ / 32767.0, -1.0 ) : 0;
+  if ( state_.axis_x < 0 ) analog |= SbInputState::bit(SbAction::left);
+  if ( state_.axis_x > 0 ) analog |= SbInputState::bit(SbAction::right);
+  if ( state_.axis_y < 0 ) analog |= SbInputState::bit(SbAction::up);
+  if ( state_.axis_y > 0 ) analog |= SbInputState::bit(SbAction::down);
+  // a key or button held for the same action counts as digital
+  analog &= ~held;
+  held |= analog;
+
+  state_.pressed = pressed_ | ( held & ~state_.held );
+  state_.released = state_.held & ~held;
+  state_.held = held;
+  state_.analog = analog;
+  state_.delta_t = timer_.started() ? timer_.get_time() : 0;
+  timer_.start();
+  pressed_ = 0;
+  return state_;
+}
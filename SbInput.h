@@ -0,0 +1,93 @@
+/*! \file SbInput.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBINPUT_H
+#define SBINPUT_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+#include "SbTimer.h"
+
+
+enum class SbAction : uint32_t {
+  up, down, left, right, jump, quit, rewind
+};
+
+
+
+/*! What the player asks for in one frame, made by SbInput::sample(). Actions are bits, see bit().
+ */
+struct SbInputState
+{
+  //! actions held at the end of the frame
+  uint32_t held = 0;
+  //! actions that went down during the frame, including presses already released again
+  uint32_t pressed = 0;
+  uint32_t released = 0;
+  //! held actions that only come from a stick, for movers that accelerate less on a stick
+  uint32_t analog = 0;
+  //! stick position from -1 to 1, 0 inside the dead zone
+  double axis_x = 0;
+  double axis_y = 0;
+  //! ms since the previous frame
+  Uint32 delta_t = 0;
+
+  static uint32_t bit(SbAction action) { return 1u << static_cast<uint32_t>(action); }
+  bool is_held(SbAction action) const { return held & bit(action); }
+  bool was_pressed(SbAction action) const { return pressed & bit(action); }
+  bool was_released(SbAction action) const { return released & bit(action); }
+  bool is_analog(SbAction action) const { return analog & bit(action); }
+  //! a press for this frame only, e.g. from an autopilot
+  void press(SbAction action) { pressed |= bit(action); }
+};
+
+
+
+/*! Turns keyboard, game controller and joystick into one SbInputState per frame.
+  The keyboard is read once per frame through SbEventSource::keyboard_state(), so it follows replays. Controller buttons and the stick of controller or joystick 0 are taken from their events, which SbEventSource records. Keys and buttons are bound to actions, the stick always gives up, down, left, right.
+  Default bindings: arrow keys, space to jump, escape to quit, backspace to rewind; d-pad, A to jump, B to quit.
+ */
+class SbInput
+{
+ public:
+  SbInput();
+
+  void bind_key(SDL_Scancode key, SbAction action);
+  void bind_button(SDL_GameControllerButton button, SbAction action);
+  void clear_bindings();
+
+  /*! Pass every event of the frame, only key presses, controller buttons and axis motion are used.
+   */
+  void handle_event(const SDL_Event& event);
+  /*! Call once per frame after the events, makes state() for this frame.
+   */
+  const SbInputState& sample();
+  const SbInputState& state() const { return state_; }
+
+  //! stick deflection ignored around the centre
+  int deadzone = 6000;
+
+ private:
+  //! actions bound to each scancode, 0 for unbound keys
+  std::array<uint32_t, SDL_NUM_SCANCODES> key_actions_ = {{}};
+  //! the bound scancodes, the keys read every frame
+  std::vector<SDL_Scancode> bound_keys_;
+  std::array<uint32_t, SDL_CONTROLLER_BUTTON_MAX> button_actions_ = {{}};
+  //! bit per controller button that is down
+  uint32_t buttons_down_ = 0;
+  //! pressed by events since the last sample()
+  uint32_t pressed_ = 0;
+  Sint16 axis_x_ = 0;
+  Sint16 axis_y_ = 0;
+  SbTimer timer_;
+  SbInputState state_;
+};
+
+
+#endif  // SBINPUT_H
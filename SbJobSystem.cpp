@@ -0,0 +1,217 @@
+/*! \file SbJobSystem.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+#include <exception>
+
+#include "SbJobSystem.h"
+
+
+namespace {
+  //! the job system and worker index of the calling thread, -1 outside the workers
+  thread_local const SbJobSystem* current_system = nullptr;
+  thread_local int current_worker = -1;
+}
+
+
+unsigned
+SbJobSystem::default_workers()
+{
+  unsigned cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 0;
+}
+
+
+
+SbJobSystem::SbJobSystem(unsigned n_workers)
+{
+  for ( unsigned i = 0; i <= n_workers; ++i )
+    queues_.emplace_back( new Queue );
+  for ( unsigned i = 0; i < n_workers; ++i )
+    workers_.emplace_back( &SbJobSystem::work, this, int(i) );
+}
+
+
+
+SbJobSystem::~SbJobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock( sleep_mutex_ );
+    stop_ = true;
+  }
+  work_available_.notify_all();
+  for ( auto& worker: workers_ )
+    worker.join();
+}
+
+
+
+SbJobSystem::Handle
+SbJobSystem::submit(std::function<void()> work, const std::vector<Handle>& after)
+{
+  Handle job = std::make_shared<Job>();
+  job->work = std::move(work);
+  for ( const Handle& before: after ) {
+    std::lock_guard<std::mutex> lock( before->mutex );
+    if ( !before->done ) {
+      ++job->pending;
+      before->successors.push_back( job );
+    }
+  }
+  if ( --job->pending == 0 )
+    schedule( job );
+  return job;
+}
+
+
+
+void
+SbJobSystem::schedule(Handle job)
+{
+  size_t index = ( current_system == this && current_worker >= 0 ) ? current_worker : queues_.size() - 1;
+  {
+    // counted before it can be taken, a worker running it right away must not take queued_ below 0
+    std::lock_guard<std::mutex> lock( sleep_mutex_ );
+    ++queued_;
+  }
+  {
+    std::lock_guard<std::mutex> lock( queues_[index]->mutex );
+    queues_[index]->jobs.push_back( std::move(job) );
+  }
+  work_available_.notify_one();
+}
+
+
+
+bool
+SbJobSystem::run_one(int self)
+{
+  Handle job;
+  if ( self >= 0 ) {
+    Queue& own = *queues_[self];
+    std::lock_guard<std::mutex> lock( own.mutex );
+    if ( !own.jobs.empty() ) {
+      job = std::move( own.jobs.back() );
+      own.jobs.pop_back();
+    }
+  }
+  // steal, starting after the own queue so that thieves spread out
+  for ( size_t n = 0; !job && n < queues_.size(); ++n ) {
+    Queue& other = *queues_[ ( self + 1 + n ) % queues_.size() ];
+    std::lock_guard<std::mutex> lock( other.mutex );
+    if ( !other.jobs.empty() ) {
+      job = std::move( other.jobs.front() );
+      other.jobs.pop_front();
+    }
+  }
+  if ( !job )
+    return false;
+  --queued_;
+  try {
+    job->work();
+  }
+  catch (...) {
+    job->error = std::current_exception();
+  }
+  finish( job );
+  return true;
+}
+
+
+
+void
+SbJobSystem::finish(const Handle& job)
+{
+  std::vector<Handle> successors;
+  {
+    std::lock_guard<std::mutex> lock( job->mutex );
+    job->done = true;
+    successors.swap( job->successors );
+  }
+  job->work = nullptr;
+  for ( Handle& next: successors ) {
+    if ( --next->pending == 0 )
+      schedule( std::move(next) );
+  }
+  {
+    std::lock_guard<std::mutex> lock( sleep_mutex_ );
+  }
+  job_done_.notify_all();
+}
+
+
+
+void
+SbJobSystem::work(int self)
+{
+  current_system = this;
+  current_worker = self;
+  while ( true ) {
+    if ( run_one(self) )
+      continue;
+    std::unique_lock<std::mutex> lock( sleep_mutex_ );
+    work_available_.wait( lock, [this]() { return stop_ || queued_ > 0; } );
+    if ( stop_ )
+      return;
+  }
+}
+
+
+
+void
+SbJobSystem::wait(const Handle& job)
+{
+  int self = ( current_system == this ) ? current_worker : -1;
+  while ( !job->done ) {
+    if ( run_one(self) )
+      continue;
+    // nothing to run: the job or one it waits for is running elsewhere
+    std::unique_lock<std::mutex> lock( sleep_mutex_ );
+    job_done_.wait( lock, [&]() { return job->done || queued_ > 0; } );
+  }
+  if ( job->error )
+    std::rethrow_exception( job->error );
+}
+
+
+
+void
+SbJobSystem::wait(const std::vector<Handle>& jobs)
+{
+  for ( const Handle& job: jobs )
+    wait( job );
+}
+
+
+
+void
+SbJobSystem::parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+  if ( grain == 0 )
+    grain = 1;
+  if ( workers_.empty() || end - begin <= grain ) {
+    for ( size_t first = begin; first < end; first += grain )
+      body( first, std::min( first + grain, end ) );
+    return;
+  }
+  std::vector<Handle> chunks;
+  for ( size_t first = begin; first < end; first += grain ) {
+    size_t last = std::min( first + grain, end );
+    chunks.push_back( submit( [&body, first, last]() { body( first, last ); } ) );
+  }
+  // let every chunk finish before an error leaves the caller's frame, body is a reference into it
+  std::exception_ptr error;
+  for ( const Handle& chunk: chunks ) {
+    try {
+      wait( chunk );
+    }
+    catch (...) {
+      if ( !error )
+	error = std::current_exception();
+    }
+  }
+  if ( error )
+    std::rethrow_exception( error );
+}
@@ -0,0 +1,90 @@
+/*! \file SbJobSystem.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBJOBSYSTEM_H
+#define SBJOBSYSTEM_H
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+
+/*! Runs jobs on a fixed set of worker threads, e.g. to spread the update phase of a frame over the cores.
+  Every worker has its own deque: jobs submitted by a worker go to the back of its deque and it takes them from there, an idle worker steals from the front of the others'. A job can depend on other jobs and is only started once they have finished. wait() and parallel_for() let the calling thread run jobs too instead of blocking, so with no workers at all everything runs on the caller.
+  parallel_for() always cuts a range into the same chunks, independent of the number of workers and of who runs which chunk, so that a body which only writes to its own chunk gives the same result as a loop.
+ */
+class SbJobSystem
+{
+  struct Job;
+ public:
+  typedef std::shared_ptr<Job> Handle;
+
+  /*! n_workers threads besides the caller, by default one less than the number of cores.
+   */
+  explicit SbJobSystem(unsigned n_workers = default_workers());
+  //! jobs not started yet are dropped
+  ~SbJobSystem();
+  SbJobSystem(const SbJobSystem&) = delete;
+  SbJobSystem& operator=(const SbJobSystem&) = delete;
+
+  /*! Run work once all jobs in after have finished.
+   */
+  Handle submit(std::function<void()> work, const std::vector<Handle>& after = {});
+  /*! Returns when job has finished, running other jobs meanwhile. Exceptions thrown by the job are rethrown here.
+   */
+  void wait(const Handle& job);
+  void wait(const std::vector<Handle>& jobs);
+  /*! Calls body(chunk_begin, chunk_end) for the chunks [begin + k*grain, begin + (k+1)*grain) of [begin, end) and waits for all of them.
+   */
+  void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& body);
+  unsigned n_workers() const { return workers_.size(); }
+
+  static unsigned default_workers();
+
+ private:
+  struct Job
+  {
+    std::function<void()> work;
+    //! jobs this one waits for, plus one while it is being submitted
+    std::atomic<uint32_t> pending{1};
+    std::atomic<bool> done{false};
+    std::mutex mutex;
+    //! jobs waiting for this one, guarded by mutex
+    std::vector<Handle> successors;
+    std::exception_ptr error;
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Handle> jobs;
+  };
+
+  void schedule(Handle job);
+  //! run one job: own queue first (from the back), then steal (from the front)
+  bool run_one(int self);
+  void finish(const Handle& job);
+  void work(int self);
+
+  //! one per worker, the last one for jobs submitted from other threads
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  //! jobs in all queues, counted before they are pushed
+  std::atomic<size_t> queued_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable job_done_;
+  bool stop_ = false;
+};
+
+
+#endif  // SBJOBSYSTEM_H
@@ -0,0 +1,282 @@
+/*! \file SbLevelFile.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <type_traits>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SbLevelFile.h"
+
+
+static_assert( sizeof(SbRectangle) == 4 * sizeof(double) && std::is_trivially_copyable<SbRectangle>::value, "SbRectangle is stored as is in level files" );
+static_assert( sizeof(MovementRange) == 4 * sizeof(double) && std::is_trivially_copyable<MovementRange>::value, "MovementRange is stored as is in level files" );
+static_assert( sizeof(Velocity) == 2 * sizeof(double) && std::is_trivially_copyable<Velocity>::value, "Velocity is stored as is in level files" );
+
+namespace {
+  const char magic[4] = {'S','B','L','V'};
+
+  uint64_t align(uint64_t offset) { return ( offset + 7 ) & ~uint64_t(7); }
+
+  uint32_t n_chunks(int length) { return std::max( 1, ( length + int(SbLevelFile::chunk_size) - 1 ) / int(SbLevelFile::chunk_size) ); }
+}
+
+
+
+SbLevelFile::SbLevelFile(const std::string& filename)
+  : filename_(filename)
+{
+  int fd = open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error("[SbLevelFile::SbLevelFile] Error: Couldn't open level file " + filename + ": " + std::strerror(errno) );
+  struct stat info;
+  if ( fstat( fd, &info ) != 0 || info.st_size < off_t(sizeof(Header)) ) {
+    close(fd);
+    throw std::runtime_error("[SbLevelFile::SbLevelFile] Error: " + filename + " is not a level file" );
+  }
+  size_ = info.st_size;
+  void* mapped = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close(fd);
+  if ( mapped == MAP_FAILED )
+    throw std::runtime_error("[SbLevelFile::SbLevelFile] Error: Couldn't map " + filename + ": " + std::strerror(errno) );
+  data_ = static_cast<const uint8_t*>(mapped);
+
+  const Header* header = reinterpret_cast<const Header*>(data_);
+  if ( std::memcmp( header->magic, magic, sizeof(magic) ) != 0 || header->version != version ) {
+    munmap( const_cast<uint8_t*>(data_), size_ );
+    throw std::runtime_error("[SbLevelFile::SbLevelFile] Error: " + filename + " is not a level file of version " + std::to_string(version) );
+  }
+  n_levels_ = header->n_levels;
+  records_ = array<Record>( sizeof(Header), n_levels_ );
+  if ( !records_ && n_levels_ > 0 ) {
+    munmap( const_cast<uint8_t*>(data_), size_ );
+    throw std::runtime_error("[SbLevelFile::SbLevelFile] Error: " + filename + " is truncated" );
+  }
+}
+
+
+
+SbLevelFile::~SbLevelFile()
+{
+  if ( data_ )
+    munmap( const_cast<uint8_t*>(data_), size_ );
+}
+
+
+
+template<typename T>
+const T*
+SbLevelFile::array(uint64_t offset, uint64_t n) const
+{
+  if ( offset % alignof(T) != 0 || offset > size_ || ( size_ - offset ) / sizeof(T) < n )
+    return nullptr;
+  return reinterpret_cast<const T*>( data_ + offset );
+}
+
+
+
+SbLevelView
+SbLevelFile::level(uint32_t num) const
+{
+  if ( num >= n_levels_ )
+    throw std::runtime_error("[SbLevelFile::level] No level found for level number = " + std::to_string(num) + " in " + filename_ );
+  const Record& record = records_[num];
+  SbLevelView view;
+  view.dimension = SbDimension( record.width, record.height );
+  view.goal = record.goal;
+  view.n_tiles = record.n_tiles;
+  view.tiles = array<SbRectangle>( record.tiles_offset, record.n_tiles );
+  if ( record.ranges_offset ) {
+    view.ranges = array<MovementRange>( record.ranges_offset, record.n_tiles );
+    view.velocities = array<Velocity>( record.velocities_offset, record.n_tiles );
+  }
+  view.chunk_size = record.chunk_size;
+  view.chunk_columns = record.chunk_columns;
+  view.chunk_rows = record.chunk_rows;
+  uint64_t n_chunks = uint64_t(record.chunk_columns) * record.chunk_rows;
+  view.chunks = array<SbLevelChunk>( record.chunks_offset, n_chunks );
+  bool chunks_ok = view.chunks && view.chunk_size > 0;
+  if ( chunks_ok ) {
+    // the last chunk ends the chunk tile list
+    uint64_t n_chunk_tiles = n_chunks ? view.chunks[n_chunks - 1].first + view.chunks[n_chunks - 1].count : 0;
+    view.chunk_tiles = array<uint32_t>( record.chunk_tiles_offset, n_chunk_tiles );
+    chunks_ok = ( view.chunk_tiles != nullptr );
+  }
+  if ( !view.tiles || !chunks_ok || bool(view.ranges) != bool(record.ranges_offset) || bool(view.velocities) != bool(record.ranges_offset) )
+    throw std::runtime_error("[SbLevelFile::level] Error: level " + std::to_string(num) + " in " + filename_ + " is corrupt" );
+  return view;
+}
+
+
+
+void
+SbLevelFile::write(const std::string& filename, const std::vector<SbLevelData>& levels)
+{
+  // chunk index: the tiles overlapping each chunk, in pixels as SbObject places them
+  std::vector<std::vector<SbLevelChunk>> chunks( levels.size() );
+  std::vector<std::vector<uint32_t>> chunk_tiles( levels.size() );
+  for ( size_t i = 0; i < levels.size(); ++i ) {
+    const SbLevelData& level = levels.at(i);
+    uint32_t columns = n_chunks( level.dimension.w );
+    uint32_t rows = n_chunks( level.dimension.h );
+    std::vector<std::vector<uint32_t>> lists( columns * rows );
+    auto chunk_of = [](int position, uint32_t n_chunks) {
+      return uint32_t( std::min<int64_t>( std::max<int64_t>( position / int(chunk_size), 0 ), n_chunks - 1 ) );
+    };
+    for ( uint32_t tile = 0; tile < level.tiles.size(); ++tile ) {
+      const SbRectangle& box = level.tiles.at(tile);
+      int x = box.x * level.dimension.w, y = box.y * level.dimension.h;
+      int w = box.w * level.dimension.w, h = box.h * level.dimension.h;
+      for ( uint32_t row = chunk_of( y, rows ); row <= chunk_of( y + h, rows ); ++row )
+	for ( uint32_t column = chunk_of( x, columns ); column <= chunk_of( x + w, columns ); ++column )
+	  lists.at( row * columns + column ).push_back( tile );
+    }
+    for ( auto& list: lists ) {
+      SbLevelChunk chunk = { chunk_tiles.at(i).size(), uint32_t(list.size()), 0 };
+      chunks.at(i).push_back( chunk );
+      chunk_tiles.at(i).insert( chunk_tiles.at(i).end(), list.begin(), list.end() );
+    }
+  }
+
+  // lay out the arrays behind the record table
+  std::vector<Record> records( levels.size() );
+  uint64_t offset = sizeof(Header) + levels.size() * sizeof(Record);
+  for ( size_t i = 0; i < levels.size(); ++i ) {
+    const SbLevelData& level = levels.at(i);
+    bool moving = !level.ranges.empty();
+    if ( moving && ( level.ranges.size() != level.tiles.size() || level.velocities.size() != level.tiles.size() ) )
+      throw std::runtime_error("[SbLevelFile::write] Error: level " + std::to_string(i) + " needs one range and velocity per tile" );
+    Record& record = records.at(i);  // value initialized, all zero
+    record.width = level.dimension.w;
+    record.height = level.dimension.h;
+    record.goal = level.goal;
+    record.n_tiles = level.tiles.size();
+    record.tiles_offset = offset = align(offset);
+    offset += level.tiles.size() * sizeof(SbRectangle);
+    if ( moving ) {
+      record.ranges_offset = offset = align(offset);
+      offset += level.ranges.size() * sizeof(MovementRange);
+      record.velocities_offset = offset = align(offset);
+      offset += level.velocities.size() * sizeof(Velocity);
+    }
+    record.chunk_size = chunk_size;
+    record.chunk_columns = n_chunks( level.dimension.w );
+    record.chunk_rows = n_chunks( level.dimension.h );
+    record.chunks_offset = offset = align(offset);
+    offset += chunks.at(i).size() * sizeof(SbLevelChunk);
+    record.chunk_tiles_offset = offset = align(offset);
+    offset += chunk_tiles.at(i).size() * sizeof(uint32_t);
+  }
+
+  // written next to the target and renamed over it, so that a running game that has the old file mapped keeps a complete copy
+  std::string temporary = filename + ".tmp";
+  std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+  if ( !file )
+    throw std::runtime_error("[SbLevelFile::write] Error: Couldn't open file " + temporary );
+  Header header;
+  std::memcpy( header.magic, magic, sizeof(magic) );
+  header.version = version;
+  header.n_levels = levels.size();
+  header.reserved = 0;
+  file.write( reinterpret_cast<const char*>(&header), sizeof(header) );
+  file.write( reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record) );
+  auto pad_to = [&file](uint64_t target) {
+    while ( uint64_t(file.tellp()) < target )
+      file.put(0);
+  };
+  for ( size_t i = 0; i < levels.size(); ++i ) {
+    const SbLevelData& level = levels.at(i);
+    pad_to( records.at(i).tiles_offset );
+    file.write( reinterpret_cast<const char*>(level.tiles.data()), level.tiles.size() * sizeof(SbRectangle) );
+    if ( records.at(i).ranges_offset ) {
+      pad_to( records.at(i).ranges_offset );
+      file.write( reinterpret_cast<const char*>(level.ranges.data()), level.ranges.size() * sizeof(MovementRange) );
+      pad_to( records.at(i).velocities_offset );
+      file.write( reinterpret_cast<const char*>(level.velocities.data()), level.velocities.size() * sizeof(Velocity) );
+    }
+    pad_to( records.at(i).chunks_offset );
+    file.write( reinterpret_cast<const char*>(chunks.at(i).data()), chunks.at(i).size() * sizeof(SbLevelChunk) );
+    pad_to( records.at(i).chunk_tiles_offset );
+    file.write( reinterpret_cast<const char*>(chunk_tiles.at(i).data()), chunk_tiles.at(i).size() * sizeof(uint32_t) );
+  }
+  file.close();
+  if ( !file || std::rename( temporary.c_str(), filename.c_str() ) != 0 ) {
+    std::remove( temporary.c_str() );
+    throw std::runtime_error("[SbLevelFile::write] Error: Couldn't write " + filename );
+  }
+}
+
+
+
+std::vector<SbLevelData>
+SbLevelFile::read_text(const std::string& filename)
+{
+  std::ifstream file( filename );
+  if ( !file )
+    throw std::runtime_error("[SbLevelFile::read_text] Error: Couldn't open file " + filename );
+  std::vector<SbLevelData> levels;
+  std::string line;
+  uint32_t line_number = 0;
+  auto fail = [&]() {
+    throw std::runtime_error("[SbLevelFile::read_text] Error in " + filename + " line " + std::to_string(line_number) + ": " + line );
+  };
+  
+  while ( std::getline( file, line ) ) {
+    ++line_number;
+    std::istringstream strstr( line.substr( 0, line.find('#') ) );
+    std::string key;
+    if ( !(strstr >> key) )
+      continue;
+    if ( key == "level" ) {
+      levels.emplace_back();
+      if ( !(strstr >> levels.back().dimension.w >> levels.back().dimension.h) )
+	fail();
+      continue;
+    }
+    if ( levels.empty() )
+      fail();
+    SbLevelData& level = levels.back();
+    SbRectangle box;
+    if ( !(strstr >> box.x >> box.y >> box.w >> box.h) )
+      fail();
+    if ( key == "goal" )
+      level.goal = box;
+    else if ( key == "tile" ) {
+      MovementRange range;
+      Velocity velocity;
+      bool moving = false;
+      while ( strstr >> key ) {
+	if ( key == "range" && (strstr >> range.left >> range.right >> range.top >> range.bottom) )
+	  moving = true;
+	else if ( key == "velocity" && (strstr >> velocity.x >> velocity.y) )
+	  moving = true;
+	else
+	  fail();
+      }
+      // once one tile moves, every tile of the level gets a range and velocity
+      if ( moving && level.ranges.empty() ) {
+	level.ranges.resize( level.tiles.size() );
+	level.velocities.resize( level.tiles.size() );
+      }
+      level.tiles.push_back( box );
+      if ( !level.ranges.empty() ) {
+	level.ranges.push_back( range );
+	level.velocities.push_back( velocity );
+      }
+    }
+    else
+      fail();
+  }
+  return levels;
+}
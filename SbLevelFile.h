@@ -0,0 +1,170 @@
+/*! \file SbLevelFile.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBLEVELFILE_H
+#define SBLEVELFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "SbObject.h"
+
+
+/* MovementLimits and MovementRange are used to define moving platforms
+ */
+struct MovementLimits
+{
+  MovementLimits(uint32_t l, uint32_t r, uint32_t t, uint32_t b)
+  : left(l), right(r), top(t), bottom(b)
+  {}
+  MovementLimits() = default;
+
+  uint32_t left = 0;
+  uint32_t right = 0;
+  uint32_t top = 0;
+  uint32_t bottom = 0;
+};
+
+
+struct MovementRange
+{
+  MovementRange(double l, double r, double t, double b)
+  : left(l), right(r), top(t), bottom(b)
+  {}
+  MovementRange() = default;
+  
+  MovementLimits to_limits(uint32_t width, uint32_t height) const {
+    MovementLimits result;
+    result.left = left * width;
+    result.right = right * width;
+    result.top = top * height;
+    result.bottom = bottom * height;
+    return result;
+  }
+
+  double left = 0;
+  double right = 0;
+  double top = 0;
+  double bottom = 0;
+};
+
+
+struct Velocity
+{
+  Velocity(double xdir, double ydir)
+  : x(xdir), y(ydir)
+  {}
+  Velocity() = default;
+  
+  double x = 0;
+  double y = 0;
+};
+
+
+/*! A level as stored in a level file: tile and goal boxes as fractions of the level dimension. ranges and velocities are empty or have one entry per tile (moving platforms).
+ */
+struct SbLevelData
+{
+  SbDimension dimension;
+  SbRectangle goal;
+  std::vector<SbRectangle> tiles;
+  std::vector<MovementRange> ranges;
+  std::vector<Velocity> velocities;
+};
+
+
+/*! Entry of the chunk index of a level: the indices of the tiles overlapping the chunk are chunk_tiles[first] to chunk_tiles[first+count-1].
+ */
+struct SbLevelChunk
+{
+  uint64_t first;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+
+/*! Read-only view of one level in a mapped SbLevelFile, the pointers point into the mapping.
+ */
+struct SbLevelView
+{
+  SbDimension dimension;
+  SbRectangle goal;
+  const SbRectangle* tiles = nullptr;
+  uint32_t n_tiles = 0;
+  //! nullptr if the level has no moving tiles
+  const MovementRange* ranges = nullptr;
+  const Velocity* velocities = nullptr;
+  //! the level split into square chunks of chunk_size pixels, chunk (column,row) is chunks[row * chunk_columns + column]
+  uint32_t chunk_size = 0;
+  uint32_t chunk_columns = 0;
+  uint32_t chunk_rows = 0;
+  const SbLevelChunk* chunks = nullptr;
+  const uint32_t* chunk_tiles = nullptr;
+};
+
+
+/*! Versioned binary file holding a set of levels, memory mapped so that levels are used in place without parsing or copying.
+  Layout, native byte order, all arrays 8 byte aligned:
+  header: "SBLV", version (uint32), number of levels (uint32), reserved (uint32)
+  one Record per level, followed by the tile, range and velocity arrays and the chunk index the records point to.
+  The chunk index lists the tiles overlapping each chunk of the level, so that a part of a large level can be read without touching the rest of the file.
+  Level files are made from text files with SbLevelTool, see levels/maze.txt for the text format.
+ */
+class SbLevelFile
+{
+ public:
+  static const uint32_t version = 2;
+  //! chunk edge length in pixels of the chunk index written by write()
+  static const uint32_t chunk_size = 512;
+
+  SbLevelFile(const std::string& filename);
+  SbLevelFile(const SbLevelFile&) = delete;
+  SbLevelFile& operator=(const SbLevelFile&) = delete;
+  ~SbLevelFile();
+
+  SbLevelView level(uint32_t num) const;
+  uint32_t size() const { return n_levels_; }
+  const std::string& filename() const { return filename_; }
+
+  static void write(const std::string& filename, const std::vector<SbLevelData>& levels);
+  static std::vector<SbLevelData> read_text(const std::string& filename);
+
+ private:
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    uint32_t n_levels;
+    uint32_t reserved;
+  };
+  
+  struct Record
+  {
+    int32_t width;
+    int32_t height;
+    SbRectangle goal;
+    uint64_t tiles_offset;
+    uint64_t ranges_offset;  //!< 0 if the level has no moving tiles
+    uint64_t velocities_offset;
+    uint32_t n_tiles;
+    uint32_t chunk_size;
+    uint32_t chunk_columns;
+    uint32_t chunk_rows;
+    uint64_t chunks_offset;
+    uint64_t chunk_tiles_offset;
+  };
+
+  template<typename T> const T* array(uint64_t offset, uint64_t n) const;
+  
+  std::string filename_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  uint32_t n_levels_ = 0;
+  const Record* records_ = nullptr;
+};
+
+
+#endif  // SBLEVELFILE_H
@@ -0,0 +1,47 @@
+/*! \file SbLevelTool.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+
+  Compiles a level text file (see levels/maze.txt) into a binary level file read by SbLevelFile, or generates a Maze level with SbMazeGenerator.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <chrono>
+
+#include "SbLevelFile.h"
+#include "SbMazeGenerator.h"
+
+
+int main(int argc, char* argv[])
+{
+  std::string first = ( argc > 1 ) ? argv[1] : "";
+  if ( !( argc == 3 || ( argc == 6 && first == "--maze" ) ) ) {
+    std::cerr << "usage: " << argv[0] << " <levels.txt> <levels.lvl>\n"
+	      << "       " << argv[0] << " --maze <columns> <rows> <seed> <levels.lvl>" << std::endl;
+    return 1;
+  }
+  try {
+    std::vector<SbLevelData> levels;
+    std::string output = argv[argc - 1];
+    if ( first == "--maze" ) {
+      auto start = std::chrono::steady_clock::now();
+      SbMazeGenerator generator( std::stoul( argv[2] ), std::stoul( argv[3] ), std::stoul( argv[4] ) );
+      levels.push_back( generator.generate() );
+      std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << "generated " << levels.back().dimension.w << "x" << levels.back().dimension.h << " pixel maze in " << elapsed.count() << " ms: "
+		<< generator.wall_cells() << " wall cells merged into " << levels.back().tiles.size() << " tiles" << std::endl;
+    }
+    else
+      levels = SbLevelFile::read_text( argv[1] );
+    SbLevelFile::write( output, levels );
+    SbLevelFile check( output );
+    std::cout << "wrote " << check.size() << " levels to " << output << std::endl;
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
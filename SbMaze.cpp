@@ -10,6 +10,12 @@ author: Ulrike Hager
 #include <memory>
 #include <iomanip>
 #include <iterator>
+#include <deque>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <functional>
+#include <chrono>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -20,11 +26,13 @@ author: Ulrike Hager
 #include "SbWindow.h"
 #include "SbObject.h"
 #include "SbFont.h"
+#include "SbRenderStats.h"
+#include "SbOptions.h"
+#include "SbBatchRunner.h"
 
 #include "SbMaze.h"
 
 
-
 /*! Ball implementation
  */
 Ball::Ball(const SbDimension* ref)
@@ -34,7 +42,7 @@ Ball::Ball(const SbDimension* ref)
   velocity_x_ = 0;
   velocity_ = 1.0/5000.0;
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_file(window->renderer(), "resources/ball.png", bounding_rect_.w, bounding_rect_.h );
+  texture_->from_file(window()->renderer(), "resources/ball.png", bounding_rect_.w, bounding_rect_.h );
   name_ = "ball";
 }
 
@@ -57,68 +65,29 @@ Ball::check_goal(const Goal& goal)
 
 
 void
-Ball::handle_event(const SDL_Event& event)
+Ball::control(const SbInputState& input)
 {
-  double sensitivity = 1.0 ; // controller needs slower acceleration
-  SbControlDir direction = SbControlDir::none;
-
-  if( event.type == SDL_KEYDOWN && event.key.repeat == 0  ) {
-    switch( event.key.keysym.sym  ) {
-    case SDLK_UP: direction = SbControlDir::up; break;
-    case SDLK_DOWN: direction = SbControlDir::down; break;
-    case SDLK_LEFT: direction = SbControlDir::left; break;
-    case SDLK_RIGHT: direction = SbControlDir::right; break;
-    }
-  }
-  else if( event.type == SDL_CONTROLLERAXISMOTION &&  event.jaxis.which == 0 ) {
-    switch ( event.jaxis.axis ) {
-    case 0: //X axis motion
-      sensitivity = 0.1;
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction = SbControlDir::left;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction = SbControlDir::right;
-      break;
-    case 1:
-      sensitivity = 0.1;
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction = SbControlDir::up;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction = SbControlDir::down;
-      break;
-    }
-  }
-  else if( event.type == SDL_JOYAXISMOTION &&  event.jaxis.which == 0 ) {
-    switch ( event.jaxis.axis ) {
-    case 0: //X axis motion
-      sensitivity = 0.1;
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction = SbControlDir::left;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction = SbControlDir::right;
-      break;
-    case 1:
-      sensitivity = 0.1;
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction = SbControlDir::up;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction = SbControlDir::down;
-      break;
-    }
-  }
-  else {
-    const Uint8 *state = SDL_GetKeyboardState(nullptr);
-    if (state[SDL_SCANCODE_UP] )
-      direction = SbControlDir::up; //velocity_y_ -= velocity_;
-    if (state[SDL_SCANCODE_DOWN] )
-      direction = SbControlDir::down; //velocity_y_ += velocity_;
-    if (state[SDL_SCANCODE_LEFT] )
-      direction = SbControlDir::left; //velocity_x_ -= velocity_;
-    if (state[SDL_SCANCODE_RIGHT])
-      direction = SbControlDir::right; //velocity_x_ += velocity_;
+  // a press accelerates at once, a held direction again every repeat_ms_, like the key repeat the ball used to follow
+  if ( input.pressed || !input.held )
+    repeat_time_ = 0;
+  else
+    repeat_time_ += input.delta_t;
+  bool repeat = ( repeat_time_ >= repeat_ms_ );
+  if ( repeat )
+    repeat_time_ -= repeat_ms_;
+  const std::pair<SbAction, SbControlDir> directions[] = { {SbAction::up, SbControlDir::up}, {SbAction::down, SbControlDir::down}
+							   , {SbAction::left, SbControlDir::left}, {SbAction::right, SbControlDir::right} };
+  for ( auto& direction: directions ) {
+    if ( input.was_pressed(direction.first) || ( repeat && input.is_held(direction.first) ) )
+      accelerate( direction.second, input.is_analog(direction.first) ? 0.1 : 1.0 ); // controller needs slower acceleration
   }
+}
 
 
+
+void
+Ball::accelerate(SbControlDir direction, double sensitivity)
+{
   switch (direction) {
   case SbControlDir::up :
     if (velocity_y_ > -1*velocity_max_) velocity_y_ -= ( velocity_ * sensitivity );
@@ -135,27 +104,28 @@ Ball::handle_event(const SDL_Event& event)
   default:
     break;
   }
-    /*
-    */
 }
 
 
 
 int
-Ball::move(const std::vector<std::unique_ptr<SbObject>>& level)
+Ball::move(const SbSpatialGrid& tiles)
 {
   int result = 0;
   if ( goal_ ) {
     return result;
   }
   Uint32 deltaT = timer_.get_time();
-  int x_velocity = (int)( window->width() * velocity_x_ * deltaT);
-  int y_velocity = (int)( window->height() * velocity_y_ * deltaT);  
+  int x_velocity = (int)( window()->width() * velocity_x_ * deltaT);
+  int y_velocity = (int)( window()->height() * velocity_y_ * deltaT);  
   bounding_rect_.y += y_velocity;
   bounding_rect_.x += x_velocity;
 
+  // check_hit counts touching edges as hits, look one pixel around the ball
+  SDL_Rect near = { bounding_rect_.x - 1, bounding_rect_.y - 1, bounding_rect_.w + 2, bounding_rect_.h + 2 };
+  tiles.query( near, nearby_ );
   int hits = 0 ;   // can only hit max 2 tiles at once
-  for (auto& tile: level){
+  for (auto tile: nearby_){
     SbHitPosition hit = check_hit(*tile);
     if ( hit == SbHitPosition::none )
       continue;
@@ -208,36 +178,67 @@ Ball::reset()
 
 
 
+void
+Ball::save_state(SbSnapshot& snapshot) const
+{
+  SbObject::save_state( snapshot );
+  snapshot.write( goal_ );
+  snapshot.write( repeat_time_ );
+}
+
+
+
+void
+Ball::restore_state(SbSnapshot& snapshot)
+{
+  SbObject::restore_state( snapshot );
+  snapshot.read( goal_ );
+  snapshot.read( repeat_time_ );
+}
+
+
+
+
 /*! Tile implementation
  */
 Tile::Tile(int x, int y, int width, int height, const SbDimension* ref)
   : SbObject(SDL_Rect{x, y, width, height}, ref)
 {
-  SDL_Color color = {40, 40, 160, 0};
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color );
+  texture_->from_rectangle( window()->renderer(), bounding_rect_.w, bounding_rect_.h, TILE_COLOR );
   name_ = "tile";
 }
 
 
-Tile::Tile( SbRectangle bounding_box, const SbDimension* ref )
+Tile::Tile( SbRectangle bounding_box, const SbDimension* ref, SbArena* arena )
   : SbObject( bounding_box, ref)
 {
-  SDL_Color color = {40, 40, 160, 0};
-  texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color );
+  texture_ = arena ? std::allocate_shared<SbTexture>( SbArena::Allocator<SbTexture>(arena) ) : std::make_shared<SbTexture>();
+  texture_->from_rectangle( window()->renderer(), bounding_rect_.w, bounding_rect_.h, TILE_COLOR );
   name_ = "tile";
 }
 
 
 
+void
+Tile::reshape( SbRectangle bounding_box )
+{
+  SDL_Rect old = bounding_rect_;
+  bounding_box_ = bounding_box;
+  update_size();
+  if ( bounding_rect_.w != old.w || bounding_rect_.h != old.h )
+    texture_->from_rectangle( window()->renderer(), bounding_rect_.w, bounding_rect_.h, TILE_COLOR );
+}
+
+
+
 /*! Goal implementation
  */
 Goal::Goal(int x, int y, int width, int height, const SbDimension* ref)
   : SbObject(SDL_Rect{x, y, width, height}, ref)
 {
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_file(window->renderer(), "resources/goal.png", bounding_rect_.w, bounding_rect_.h );
+  texture_->from_file(window()->renderer(), "resources/goal.png", bounding_rect_.w, bounding_rect_.h );
   name_ = "goal";
 }
 
@@ -246,16 +247,156 @@ Goal::Goal(SbRectangle box, const SbDimension* ref)
   : SbObject(box, ref)
 {
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_file(window->renderer(), "resources/goal.png", bounding_rect_.w, bounding_rect_.h );
+  texture_->from_file(window()->renderer(), "resources/goal.png", bounding_rect_.w, bounding_rect_.h );
   name_ = "goal";
 }
 
 
 
+/*! Autopilot implementation
+ */
+void
+Autopilot::plan(const Level& level, const Ball& ball)
+{
+  level_ = &level;
+  route_.clear();
+  next_ = 0;
+  progress_.start();
+
+  const SbDimension* dim = level.get_dimension();
+  const int cell = std::max( ball.width(), 1 );
+  const int columns = dim->w / cell;
+  const int rows = dim->h / cell;
+  if ( columns <= 0 || rows <= 0 )
+    return;
+  
+  // a cell is free if the ball centred in it keeps some clearance to all tiles
+  const int clearance = ball.width()/2 + cell/4;
+  std::vector<bool> blocked( columns * rows, false );
+  for ( auto& tile: level.tiles() ) {
+    SDL_Rect box = tile->bounding_rect();
+    box.x -= clearance;
+    box.y -= clearance;
+    box.w += 2*clearance;
+    box.h += 2*clearance;
+    int first_column = std::max( 0, box.x / cell ), last_column = std::min( columns - 1, (box.x + box.w) / cell );
+    int first_row = std::max( 0, box.y / cell ), last_row = std::min( rows - 1, (box.y + box.h) / cell );
+    for ( int row = first_row; row <= last_row; ++row ) {
+      int centre_y = row * cell + cell/2;
+      if ( centre_y <= box.y || centre_y >= box.y + box.h )
+	continue;
+      for ( int column = first_column; column <= last_column; ++column ) {
+	int centre_x = column * cell + cell/2;
+	if ( centre_x > box.x && centre_x < box.x + box.w )
+	  blocked[ row * columns + column ] = true;
+      }
+    }
+  }
+
+  auto cell_of = [&](int x, int y) {
+    int column = std::min( std::max( x / cell, 0 ), columns - 1 );
+    int row = std::min( std::max( y / cell, 0 ), rows - 1 );
+    return row * columns + column;
+  };
+  const SDL_Rect& goal_box = level.goal().bounding_rect();
+  SDL_Point goal = { goal_box.x + goal_box.w/2, goal_box.y + goal_box.h/2 };
+  int start = cell_of( ball.pos_x() + ball.width()/2, ball.pos_y() + ball.height()/2 );
+  int target = cell_of( goal.x, goal.y );
+  blocked[start] = false;
+  blocked[target] = false;
+
+  // breadth first search, 4-connected
+  std::vector<int> parent( columns * rows, -1 );
+  std::deque<int> queue = { start };
+  parent[start] = start;
+  while ( !queue.empty() && parent[target] < 0 ) {
+    int current = queue.front();
+    queue.pop_front();
+    int column = current % columns, row = current / columns;
+    const int neighbours[4][2] = { {column-1, row}, {column+1, row}, {column, row-1}, {column, row+1} };
+    for ( auto& n: neighbours ) {
+      if ( n[0] < 0 || n[0] >= columns || n[1] < 0 || n[1] >= rows )
+	continue;
+      int index = n[1] * columns + n[0];
+      if ( blocked[index] || parent[index] >= 0 )
+	continue;
+      parent[index] = current;
+      queue.push_back(index);
+    }
+  }
+
+  // keep only the corners of the path, the goal centre is the last way point
+  if ( parent[target] >= 0 ) {
+    std::vector<int> path;
+    for ( int index = target; index != start; index = parent[index] )
+      path.push_back(index);
+    std::reverse( path.begin(), path.end() );
+    for ( size_t i = 0; i + 1 < path.size(); ++i ) {
+      int previous = ( i == 0 ) ? start : path[i-1];
+      if ( path[i] - previous != path[i+1] - path[i] )
+	route_.push_back( SDL_Point{ (path[i] % columns) * cell + cell/2, (path[i] / columns) * cell + cell/2 } );
+    }
+  }
+#ifdef DEBUG
+  else
+    std::cout << "[Autopilot::plan] no route found, heading straight for the goal" << std::endl;
+#endif
+  route_.push_back( goal );
+}
+
+
+
+void
+Autopilot::push(Ball& ball, SbInputState& input, int distance, int tolerance, double velocity, double scale, SbAction decrease, SbAction increase)
+{
+  // aim for a velocity that slows down when closing in but never drops below one key press as long as the way point is not reached
+  // velocities in pixel/ms are converted to the ball's units with scale
+  double wanted = 0;
+  if ( std::abs(distance) > tolerance ) {
+    wanted = std::max( std::min( std::abs(distance) / 300.0, max_speed_ ) * scale, ball.velocity_step() );
+    if ( distance < 0 )
+      wanted *= -1;
+  }
+  double deadband = ball.velocity_step() / 2;
+  if ( velocity < wanted - deadband )
+    input.press( increase );
+  else if ( velocity > wanted + deadband )
+    input.press( decrease );
+}
+
+
+
+void
+Autopilot::steer(Ball& ball, SbInputState& input)
+{
+  if ( route_.empty() )
+    return;
+  if ( progress_.get_time() > stuck_time_ && level_ ) {
+    plan( *level_, ball );
+    return;
+  }
+
+  const int tolerance = ball.width() / 3;
+  int x = ball.pos_x() + ball.width()/2;
+  int y = ball.pos_y() + ball.height()/2;
+  while ( next_ + 1 < route_.size()
+	  && std::abs( route_[next_].x - x ) <= tolerance
+	  && std::abs( route_[next_].y - y ) <= tolerance ) {
+    ++next_;
+    progress_.start();
+  }
+  
+  push( ball, input, route_[next_].x - x, tolerance, ball.velocity_x(), 1.0 / SbObject::window()->width(), SbAction::left, SbAction::right );
+  push( ball, input, route_[next_].y - y, tolerance, ball.velocity_y(), 1.0 / SbObject::window()->height(), SbAction::up, SbAction::down );
+}
+
+
+
 /*! Level implementation
  */
-Level::Level(int num, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref)
-  : level_num_(num)
+Level::Level(const SbLevelFile& levels, int num, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref)
+  : levels_(&levels)
+  , level_num_(num)
   , time_message_(SbRectangle{0.9,0,0.1,0.07}, window_ref)
 {
   create_level(level_num_);
@@ -263,23 +404,308 @@ Level::Level(int num, std::shared_ptr<TTF_Font> font, const SbDimension* window_
 }
 
 
+Level::Level(const SbLevelFile& levels, LevelLayout layout, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref)
+  : levels_(&levels)
+  , level_num_(layout.number)
+  , time_message_(SbRectangle{0.9,0,0.1,0.07}, window_ref)
+{
+  layout_ = std::move( layout );
+  dimension_ = layout_.dimension;
+  if ( layout_.stream )
+    start_streaming();
+  else {
+    grid_.reset( dimension_ );
+    tiles_.reserve( layout_.tiles.size() );
+  }
+  goal_ = arena_.create<Goal>( layout_.goal, get_dimension() );
+  time_message_.set_font(font);
+}
+
+
+LevelLayout
+Level::layout(const SbLevelFile& levels, uint32_t num)
+{
+  SbLevelView level = levels.level(num);
+  LevelLayout result;
+  result.number = num;
+  result.dimension = level.dimension;
+  result.goal = level.goal;
+  result.tiles_in_file = level.n_tiles;
+  result.stream = ( level.n_tiles > STREAM_THRESHOLD );
+  // overlapping and adjacent walls become one tile, fewer hit checks, textures and draw calls
+  if ( !result.stream )
+    result.tiles = SbTileOptimizer::optimize( level.tiles, level.n_tiles, level.dimension );
+  return result;
+}
+
+
+bool
+Level::build(double budget_ms)
+{
+  Uint64 start = SDL_GetPerformanceCounter();
+  Uint64 budget = budget_ms * SDL_GetPerformanceFrequency() / 1000;
+  while ( !built() ) {
+    tiles_.push_back( arena_.create<Tile>( layout_.tiles[ tiles_.size() ], get_dimension(), &arena_ ) );
+    grid_.insert( tiles_.back() );
+    if ( budget_ms > 0 && SDL_GetPerformanceCounter() - start > budget )
+      break;
+  }
+  return built();
+}
+
+
 void
 Level::create_level(uint32_t num)
 {
-  if ( !tiles_.empty() )
-    tiles_.clear();
+  stop_streaming();
+  // the tiles, the goal and their textures all go at once
+  tiles_.clear();
+  goal_ = nullptr;
+  arena_.reset();
   
-  if (num > levels.size() )
-    throw std::runtime_error("[Level::create_level] No level found for level number = " + std::to_string(num)  );
+  layout_ = layout( *levels_, num );
+  level_num_ = num;
+  dimension_ = layout_.dimension;
+  if ( layout_.stream )
+    start_streaming();
+  else {
+    grid_ = SbSpatialGrid();
+    grid_.reset( dimension_ );
+    tiles_.reserve( layout_.tiles.size() );
+    build();
+  }
+  goal_ = arena_.create<Goal>( layout_.goal, get_dimension() );
+}
+
+
+
+void
+Level::start_streaming()
+{
+  streaming_ = true;
+  view_ = levels_->level( level_num_ );
+  // a cell per chunk, the grid spans the whole level
+  grid_ = SbSpatialGrid( view_.chunk_size );
+  grid_.reset( dimension_ );
+  stream_frame_ = 0;
+}
+
+
+
+void
+Level::stop_streaming()
+{
+  if ( !streaming_ )
+    return;
+  // waits for the chunks still being read
+  chunks_.clear();
+  resident_.clear();
+  // the tiles themselves stay in the arena until create_level() resets it
+  tiles_.clear();
+  tile_ids_.clear();
+  resident_bytes_ = 0;
+  n_loading_ = 0;
+  streaming_ = false;
+}
+
+
+
+void
+Level::stream(const SDL_Rect& camera)
+{
+  if ( !streaming_ )
+    return;
+  ++stream_frame_;
+  const int size = view_.chunk_size;
+  auto visit = [this, size](const SDL_Rect& box, std::function<void(uint32_t, Chunk&)> action) {
+    auto chunk_of = [size](int position, uint32_t n_chunks) {
+      return uint32_t( std::min<int64_t>( std::max( position / size, 0 ), n_chunks - 1 ) );
+    };
+    for ( uint32_t row = chunk_of( box.y, view_.chunk_rows ); row <= chunk_of( box.y + box.h, view_.chunk_rows ); ++row ) {
+      for ( uint32_t column = chunk_of( box.x, view_.chunk_columns ); column <= chunk_of( box.x + box.w, view_.chunk_columns ); ++column ) {
+	uint32_t id = row * view_.chunk_columns + column;
+	Chunk& chunk = chunks_[id];
+	chunk.last_used = stream_frame_;
+	action( id, chunk );
+      }
+    }
+  };
+
+  // what the camera sees has to be there before anything moves
+  visit( camera, [this](uint32_t id, Chunk& chunk) {
+      if ( chunk.resident )
+	return;
+      if ( !chunk.loading.valid() )
+	load_chunk( id, chunk );
+      --n_loading_;
+      add_chunk( chunk, chunk.loading.get() );
+    } );
+  // read ahead around it
+  SDL_Rect ahead = { camera.x - size, camera.y - size, camera.w + 2*size, camera.h + 2*size };
+  visit( ahead, [this](uint32_t id, Chunk& chunk) {
+      if ( !chunk.resident && !chunk.loading.valid() && n_loading_ < max_loading_ )
+	load_chunk( id, chunk );
+    } );
+
+  // build the chunks that have been read, within the frame budget
+  Uint64 start = SDL_GetPerformanceCounter();
+  Uint64 budget = stream_budget_ms_ * SDL_GetPerformanceFrequency() / 1000;
+  for ( auto& entry: chunks_ ) {
+    Chunk& chunk = entry.second;
+    if ( !chunk.loading.valid() || chunk.loading.wait_for( std::chrono::seconds(0) ) != std::future_status::ready )
+      continue;
+    --n_loading_;
+    add_chunk( chunk, chunk.loading.get() );
+    if ( SDL_GetPerformanceCounter() - start > budget )
+      break;
+  }
+
+  // forget requests that were not started, then drop the least recently used chunks
+  for ( auto entry = chunks_.begin(); entry != chunks_.end(); ) {
+    if ( !entry->second.resident && !entry->second.loading.valid() )
+      entry = chunks_.erase( entry );
+    else
+      ++entry;
+  }
+  while ( resident_bytes_ > memory_budget_ ) {
+    auto oldest = chunks_.end();
+    for ( auto entry = chunks_.begin(); entry != chunks_.end(); ++entry ) {
+      if ( entry->second.resident && entry->second.last_used < stream_frame_
+	   && ( oldest == chunks_.end() || entry->second.last_used < oldest->second.last_used ) )
+	oldest = entry;
+    }
+    if ( oldest == chunks_.end() )
+      break;
+    evict_chunk( oldest->first );
+  }
+}
+
+
 
-  dimension_ = levels.at(num).dimension;
-  std::vector< SbRectangle > &coords = (levels.at(num).tiles);
-  SbRectangle& goal = levels.at(num).goal;
+void
+Level::load_chunk(uint32_t id, Chunk& chunk)
+{
+  // reading the tiles from the mapped file is what pages them in, keep it off the render thread
+  const SbLevelView view = view_;
+  chunk.loading = std::async( std::launch::async, [view, id]() {
+      ChunkData data;
+      const SbLevelChunk& entry = view.chunks[id];
+      data.ids.assign( view.chunk_tiles + entry.first, view.chunk_tiles + entry.first + entry.count );
+      data.boxes.reserve( data.ids.size() );
+      for ( uint32_t tile: data.ids )
+	data.boxes.push_back( view.tiles[tile] );
+      return data;
+    } );
+  ++n_loading_;
+}
+
+
+
+void
+Level::add_chunk(Chunk& chunk, ChunkData data)
+{
+  for ( size_t i = 0; i < data.ids.size(); ++i ) {
+    // tiles overlapping several chunks are built once
+    auto found = resident_.find( data.ids[i] );
+    if ( found != resident_.end() ) {
+      ++found->second.chunks;
+      continue;
+    }
+    tiles_.push_back( arena_.create<Tile>( data.boxes[i], get_dimension(), &arena_ ) );
+    SbObject* tile = tiles_.back();
+    grid_.insert( tile );
+    tile_ids_.push_back( data.ids[i] );
+    ResidentTile entry = { tiles_.size() - 1, 1, uint64_t( tile->width() ) * tile->height() * 4 + sizeof(Tile) };
+    resident_bytes_ += entry.bytes;
+    resident_.emplace( data.ids[i], entry );
+  }
+  chunk.ids = std::move( data.ids );
+  chunk.resident = true;
+}
+
+
+
+void
+Level::evict_chunk(uint32_t id)
+{
+  Chunk& chunk = chunks_.at(id);
+  for ( uint32_t tile_id: chunk.ids ) {
+    auto found = resident_.find( tile_id );
+    if ( found == resident_.end() || --found->second.chunks > 0 )
+      continue;
+    size_t slot = found->second.slot;
+    grid_.remove( tiles_[slot] );
+    // its memory goes to the next tile built
+    arena_.destroy( tiles_[slot] );
+    resident_bytes_ -= found->second.bytes;
+    resident_.erase( found );
+    if ( slot + 1 != tiles_.size() ) {
+      tiles_[slot] = tiles_.back();
+      tile_ids_[slot] = tile_ids_.back();
+      resident_.at( tile_ids_[slot] ).slot = slot;
+    }
+    tiles_.pop_back();
+    tile_ids_.pop_back();
+  }
+  chunks_.erase( id );
+}
+
+
+
+uint32_t
+Level::reload(const SbLevelFile& levels)
+{
+  LevelLayout fresh = layout( levels, level_num_ );
+  levels_ = &levels;
+  if ( streaming_ || fresh.stream
+       || fresh.dimension.w != dimension_.w || fresh.dimension.h != dimension_.h ) {
+    create_level( level_num_ );
+    return tiles_.size();
+  }
+
+  // tiles that are in both versions stay as they are
+  auto key = [](const SbRectangle& box) { return std::make_tuple( box.x, box.y, box.w, box.h ); };
+  std::multimap<std::tuple<double,double,double,double>, size_t> unmatched;
+  for ( size_t i = 0; i < tiles_.size(); ++i )
+    unmatched.emplace( key( tiles_[i]->bounding_box() ), i );
+  std::vector<SbRectangle> added;
+  for ( const SbRectangle& box: fresh.tiles ) {
+    auto match = unmatched.find( key( box ) );
+    if ( match != unmatched.end() )
+      unmatched.erase( match );
+    else
+      added.push_back( box );
+  }
+  std::vector<size_t> removed;
+  for ( auto& entry: unmatched )
+    removed.push_back( entry.second );
+  
+  // reuse the tiles that went away for the new ones, then remove or add the rest
+  size_t n_reshaped = std::min( removed.size(), added.size() );
+  for ( size_t i = 0; i < n_reshaped; ++i ) {
+    Tile* tile = static_cast<Tile*>( tiles_[ removed[i] ] );
+    grid_.remove( tile );
+    tile->reshape( added[i] );
+    grid_.insert( tile );
+  }
+  std::sort( removed.begin() + n_reshaped, removed.end(), std::greater<size_t>() );
+  for ( size_t i = n_reshaped; i < removed.size(); ++i ) {
+    grid_.remove( tiles_[ removed[i] ] );
+    arena_.destroy( tiles_[ removed[i] ] );
+    tiles_[ removed[i] ] = tiles_.back();
+    tiles_.pop_back();
+  }
+  for ( size_t i = n_reshaped; i < added.size(); ++i ) {
+    tiles_.push_back( arena_.create<Tile>( added[i], get_dimension(), &arena_ ) );
+    grid_.insert( tiles_.back() );
+  }
 
-  for ( auto box: coords ){
-    tiles_.emplace_back( std::unique_ptr<SbObject>(new Tile( box, get_dimension() ) ) );
+  if ( key( goal_->bounding_box() ) != key( fresh.goal ) ) {
+    arena_.destroy( goal_ );
+    goal_ = arena_.create<Goal>( fresh.goal, get_dimension() );
   }
-  goal_ = std::unique_ptr<Goal>( new Goal{ goal, get_dimension() } );
+  layout_ = std::move( fresh );
+  return added.size() + removed.size() - n_reshaped;
 }
 
 
@@ -306,9 +732,30 @@ Level::update_size()
 
 
 
-Maze::Maze()
+void
+Level::save_state(SbSnapshot& snapshot) const
+{
+  snapshot.write( level_num_ );
+  time_message_.save_state( snapshot );
+}
+
+
+
+void
+Level::restore_state(SbSnapshot& snapshot)
+{
+  snapshot.read( level_num_ );
+  time_message_.restore_state( snapshot );
+}
+
+
+
+Maze::Maze(const std::string& level_file, const std::string& savefile)
+  : savefile_(savefile)
 {
-  SbObject::window = &window_ ;
+  SbGameContext::make_current( &context_ );
+  context_.window = &window_;
+  input_.deadzone = CONTROLLER_DEADZONE;
 
   for (int i = 0; i < SDL_NumJoysticks(); ++i) {
     if (SDL_IsGameController(i)) {
@@ -319,9 +766,7 @@ Maze::Maze()
     }
   }
 
-  levels.emplace_back(dim0, lev0, goal0);
-  levels.emplace_back(dim1, lev1, goal1);
-
+  levels_ = std::unique_ptr<SbLevelFile>( new SbLevelFile(level_file) );
   initialize();
 
 }
@@ -329,6 +774,8 @@ Maze::Maze()
 
 Maze::~Maze()
 {
+  // the members go after this, with their textures counted in this game
+  SbGameContext::make_current( &context_ );
   SDL_GameControllerClose( game_controller_ );
   game_controller_ = nullptr;
 }
@@ -343,121 +790,334 @@ Maze::initialize()
   // font_ = std::shared_ptr<TTF_Font>( TTF_OpenFont( "resources/FreeSans.ttf", 120 ), DeleteFont() );
   // if ( !font_ )
   //   throw std::runtime_error( "TTF_OpenFont: " + std::string( TTF_GetError() ) );
+  font_ = font;
 
-  level_ = std::unique_ptr<Level>( new Level(current_level_, font.font(), window_.get_dimension() ) );
+  level_ = std::unique_ptr<Level>( new Level(*levels_, current_level_, font.font(), window_.get_dimension() ) );
+  level_->set_memory_budget( memory_budget_ );
   ball_ = std::unique_ptr<Ball>( new Ball(level_->get_dimension()) );
+  ball_->center_camera(camera_, level_->width(), level_->height());
+#ifdef DEBUG
+  if ( !level_->streaming() )
+    std::cout << "[Maze] level " << level_->level_number() << ": " << level_->tiles_in_file() << " tiles merged into " << level_->tiles().size() << std::endl;
+#endif // DEBUG
   fps_display_ = std::unique_ptr<SbFpsDisplay>( new SbFpsDisplay( font.font(), SbRectangle{0, 0, 0.06, 0.035}, window_.get_dimension() ) );
+  render_stats_ = std::unique_ptr<SbRenderStatsDisplay>( new SbRenderStatsDisplay( font.font(), SbRectangle{0, 0.035, 0.3, 0.035}, window_.get_dimension() ) );
   highscore_ = std::unique_ptr<SbHighScore> (new SbHighScore( font.font(), SbRectangle{0.2,0.4,0.6,0.23}, window_.get_dimension() ) );
-  highscore_->savefile = "maze.save";
+  highscore_->savefile = savefile_;
   highscore_->prefix = "Time:" ;
   highscore_->postfix = "s";
   highscore_->set_precision(2);
+  highscore_->read_highscores();
 }
 
 
 void
 Maze::reset()
 {
-  if ( (++current_level_) == levels.size() ) {
+  if ( (++current_level_) >= levels_->size() ) {
     current_level_ = 0;
   }
-  level_->create_level( current_level_ );
+  if ( next_layout_.valid() && !next_level_ )
+    next_level_ = std::unique_ptr<Level>( new Level( *levels_, next_layout_.get(), font_.font(), window_.get_dimension() ) );
+  if ( next_level_ && next_level_->level_number() == current_level_ ) {
+    // whatever the goal delay did not get to
+    next_level_->build();
+    level_ = std::move( next_level_ );
+    level_->set_memory_budget( memory_budget_ );
+    ball_->set_reference( level_->get_dimension() );
+  }
+  else
+    level_->create_level( current_level_ );
+  next_level_.reset();
   ball_->reset();
+  ball_->center_camera(camera_, level_->width(), level_->height());
+#ifdef DEBUG
+  if ( !level_->streaming() )
+    std::cout << "[Maze] level " << level_->level_number() << ": " << level_->tiles_in_file() << " tiles merged into " << level_->tiles().size() << std::endl;
+#endif // DEBUG
   level_->start_timer();
-  reset_timer_.reset();
+  // when called before the delay is up
+  timers_.cancel( level_change_ );
   in_goal_ = false;
+  rewind_.clear();
+  if ( autopilot_ )
+    autopilot_->plan( *level_, *ball_ );
 }
 
 
-Uint32
-Maze::reset_game(Uint32 interval, void *param )
+void
+Maze::snapshot(SbSnapshot& snapshot) const
 {
-  ((Maze*)param)->reset();
-  return(0);
+  snapshot.clear();
+  snapshot.write( current_level_ );
+  snapshot.write( in_goal_ );
+  snapshot.write( timers_.remaining( level_change_ ) );
+  level_->save_state( snapshot );
+  ball_->save_state( snapshot );
 }
 
 
 
 void
-Maze::run()
+Maze::restore(SbSnapshot& snapshot)
 {
-    SDL_Event event;
-    bool quit = false;
+  snapshot.rewind();
+  uint32_t level = 0;
+  snapshot.read( level );
+  if ( level != current_level_ )
+    throw std::runtime_error("[Maze::restore] Error: snapshot of level " + std::to_string(level) + ", playing level " + std::to_string(current_level_) );
+  Uint32 remaining = 0;
+  snapshot.read( in_goal_ );
+  snapshot.read( remaining );
+  timers_.cancel( level_change_ );
+  if ( remaining > 0 )
+    level_change_ = timers_.schedule( remaining, [this]() { reset(); } );
+  level_->restore_state( snapshot );
+  ball_->restore_state( snapshot );
+}
 
-    level_->start_timer();
-    
-    while (!quit) {
-      /// begin event polling
-      while( SDL_PollEvent( &event ) ) {
-	if (event.type == SDL_QUIT) quit = true;
-	else if (event.type == SDL_KEYDOWN ) {
-	  switch ( event.key.keysym.sym ) {
-	  case SDLK_ESCAPE:
-	    quit = true;
-	    break;
-	  }
-	}
-	else if (   event.type == SDL_CONTROLLERBUTTONDOWN
-		    && event.cbutton.which == 0
-		    && event.cbutton.button == SDL_CONTROLLER_BUTTON_B ) {
-	  quit = true;
-	}
-	if (window_.handle_event(event) ){
-	  ball_->update_size();
-	  fps_display_->update_size();
-	  level_->update_size();
-	}
-	ball_->handle_event(event);
-	fps_display_->handle_event(event);
-      }
-      /// end event polling
 
-      	if ( reset_timer_.get_time() > 1500 )
-	  reset();
-	
+void
+Maze::set_autopilot(bool on)
+{
+  if ( on ) {
+    autopilot_ = std::unique_ptr<Autopilot>( new Autopilot );
+    autopilot_->plan( *level_, *ball_ );
+  }
+  else
+    autopilot_.reset();
+}
 
-      ball_->move(level_->tiles());
-      ball_->center_camera(camera_, LEVEL_WIDTH, LEVEL_HEIGHT);
-      if ( !in_goal_ ) {
-	in_goal_ = ball_->check_goal(level_->goal());
-	if (in_goal_) {
-	  //	  SDL_AddTimer(2000, Maze::reset_game, this);
-	  reset_timer_.start();
-	  level_->stop_timer();
-	  highscore_->check_highscore( level_->time(), &SbHighScore::lower, current_level_, 0.001 );
-	}
-      }
-      fps_display_->update();
-      
-      SDL_RenderClear( window_.renderer() );
-      level_->render( camera_ );
-      fps_display_->render();
-      ball_->render( camera_ );
-      if ( reset_timer_.get_time() > 0 )
-	highscore_->render();
-      SDL_RenderPresent( window_.renderer() );
 
-    }
+void
+Maze::watch_levels(bool on)
+{
+  if ( on )
+    level_watch_ = std::unique_ptr<SbFileWatch>( new SbFileWatch( levels_->filename() ) );
+  else
+    level_watch_.reset();
+}
+
+
+void
+Maze::set_memory_budget(uint64_t bytes)
+{
+  memory_budget_ = bytes;
+  if ( level_ )
+    level_->set_memory_budget( bytes );
+}
+
+
+void
+Maze::prepare_next_level()
+{
+  cancel_next_level();
+  uint32_t next = ( current_level_ + 1 < levels_->size() ) ? current_level_ + 1 : 0;
+  const SbLevelFile* levels = levels_.get();
+  next_layout_ = std::async( std::launch::async, [levels, next]() { return Level::layout( *levels, next ); } );
 }
 
 
+void
+Maze::cancel_next_level()
+{
+  if ( next_layout_.valid() )
+    next_layout_.wait();
+  next_layout_ = std::future<LevelLayout>();
+  next_level_.reset();
+}
+
 
-int main()
+void
+Maze::reload_levels()
 {
-  sdl_init();
+  // the next level may come from the old file
+  cancel_next_level();
+  // a broken file leaves the current levels in place, fix it and save again
   try {
-    Maze maze;
-    maze.run();
+    std::unique_ptr<SbLevelFile> levels( new SbLevelFile( levels_->filename() ) );
+    uint32_t n_changed = level_->reload( *levels );
+    levels_ = std::move( levels );
+#ifdef DEBUG
+    std::cout << "[Maze::reload_levels] " << levels_->filename() << ": " << n_changed << " tiles of level " << current_level_ << " updated" << std::endl;
+#endif // DEBUG
+    (void)n_changed;
   }
   catch (const std::exception& expt) {
     std::cerr << expt.what() << std::endl;
+    return;
   }
-  sdl_quit();
-  return 0;
+  if ( autopilot_ )
+    autopilot_->plan( *level_, *ball_ );
+}
+
+
+void
+Maze::run()
+{
+  level_->start_timer();
+    
+  while (!quit_)
+    frame();
+}
+
+
+
+void
+Maze::frame()
+{
+  SDL_Event event;
+
+  SbGameContext::make_current( &context_ );
+  watchdog_.begin_frame();
+  events_.begin_frame();
+  /// begin event polling
+  while( events_.poll( event ) ) {
+    if (event.type == SDL_QUIT) quit_ = true;
+    if (window_.handle_event(event) ){
+      ball_->update_size();
+      fps_display_->update_size();
+      render_stats_->update_size();
+      level_->update_size();
+    }
+    input_.handle_event(event);
+    fps_display_->handle_event(event);
+    render_stats_->handle_event(event);
+  }
+  /// end event polling
+  SbInputState input = input_.sample();
+  if ( input.was_pressed(SbAction::quit) )
+    quit_ = true;
+  watchdog_.phase("events");
+
+  if ( level_watch_ && level_watch_->changed() )
+    reload_levels();
+  timers_.update();
+  if ( next_level_ )
+    next_level_->build( prepare_budget_ms_ );
+  else if ( next_layout_.valid() && next_layout_.wait_for( std::chrono::seconds(0) ) == std::future_status::ready )
+    next_level_ = std::unique_ptr<Level>( new Level( *levels_, next_layout_.get(), font_.font(), window_.get_dimension() ) );
+	
+  level_->stream( camera_ );
+  if ( !in_goal_ && input.is_held(SbAction::rewind) ) {
+    // one frame back per frame, the clock keeps running so that rewinding does not improve the time
+    Uint32 time = level_->time();
+    if ( rewind_.step_back( snapshot_ ) )
+      restore( snapshot_ );
+    level_->set_time( time );
+  }
+  else {
+    if ( autopilot_ && !in_goal_ )
+      autopilot_->steer( *ball_, input );
+    ball_->control( input );
+    ball_->move(level_->grid());
+    if ( !in_goal_ ) {
+      in_goal_ = ball_->check_goal(level_->goal());
+      if (in_goal_) {
+	level_change_ = timers_.schedule( LEVEL_CHANGE_DELAY, [this]() { reset(); } );
+	prepare_next_level();
+	level_->stop_timer();
+	highscore_->check_highscore( level_->time(), &SbHighScore::lower, current_level_, 0.001 );
+      }
+      else {
+	snapshot( snapshot_ );
+	rewind_.push( snapshot_ );
+      }
+    }
+  }
+  ball_->center_camera(camera_, level_->width(), level_->height());
+  fps_display_->update();
+  render_stats_->update();
+  watchdog_.phase("update");
+      
+  SbRenderStats::clear( window_.renderer() );
+  level_->render( camera_ );
+  fps_display_->render();
+  render_stats_->render();
+  ball_->render( camera_ );
+  if ( in_goal_ )
+    highscore_->render();
+  watchdog_.phase("render");
+  SbRenderStats::present( window_.renderer() );
+  watchdog_.phase("present");
+  watchdog_.end_frame();
 }
-  
 
 
 
+#ifndef SB_NO_MAIN
+namespace {
+  //! frames of a scripted batch session unless --ticks says otherwise
+  const uint64_t script_ticks = 3600;
+}
 
 
+int main(int argc, char* argv[])
+{
+  SbOptions options;
+  bool autopilot = false;
+  bool watch_levels = false;
+  uint64_t memory_budget = 0;
+  std::string level_file = "resources/maze.lvl";
+  try {
+    for ( int i = 1; i < argc; ++i ) {
+      std::string arg = argv[i];
+      if ( options.parse(i, argc, argv) )
+	continue;
+      else if ( arg == "--autopilot" )
+	autopilot = true;
+      else if ( arg == "--watch-levels" )
+	watch_levels = true;
+      else if ( arg == "--memory-budget" && i + 1 < argc )
+	memory_budget = std::stoull( argv[++i] ) << 20;
+      else if ( arg == "--levels" && i + 1 < argc )
+	level_file = argv[++i];
+      else
+	throw std::runtime_error( "usage: " + std::string(argv[0]) + " [--autopilot] [--levels file.lvl] [--watch-levels] [--memory-budget MB] " + SbOptions::usage() );
+    }
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    return 1;
+  }
+  
+  sdl_init(options.headless || options.batch > 0);
+  try {
+    if ( options.batch > 0 ) {
+      // without a replay the autopilot plays, the script only moves the clock on
+      SbBatchRunner runner;
+      for ( unsigned i = 0; i < options.batch; ++i ) {
+	runner.add( [&]() {
+	    std::shared_ptr<Maze> maze( new Maze( level_file, "" ) );
+	    if ( memory_budget > 0 )
+	      maze->set_memory_budget(memory_budget);
+	    if ( options.replay.empty() ) {
+	      maze->set_autopilot(true);
+	      maze->events()->script( [](uint64_t, Uint8*, std::vector<SDL_Event>&) { return true; } );
+	    }
+	    options.apply( *maze->events(), *maze->watchdog(), *maze->window() );
+	    return SbBatchRunner::Tick( [maze]() { maze->frame(); return !maze->done(); } );
+	  } );
+      }
+      runner.run( ( options.ticks == 0 && options.replay.empty() ) ? script_ticks : options.ticks );
+      runner.print_statistics(std::cout);
+    }
+    else {
+      Maze maze(level_file);
+      maze.set_autopilot(autopilot);
+      maze.watch_levels(watch_levels);
+      if ( memory_budget > 0 )
+	maze.set_memory_budget(memory_budget);
+      options.apply( *maze.events(), *maze.watchdog(), *maze.window() );
+      maze.run();
+      if ( maze.events()->replaying() )
+	maze.events()->print_statistics(std::cout);
+    }
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+  }
+  sdl_quit();
+  return 0;
+}
+#endif  // SB_NO_MAIN
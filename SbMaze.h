@@ -7,24 +7,45 @@ author: Ulrike Hager
 
 
 #include <string>
+#include <future>
+#include <unordered_map>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
 #include "SbObject.h"
 #include "SbMessage.h"
+#include "SbFont.h"
+#include "SbEventSource.h"
+#include "SbFrameWatchdog.h"
+#include "SbWindow.h"
+#include "SbGameContext.h"
+#include "SbLevelFile.h"
+#include "SbSpatialGrid.h"
+#include "SbTileOptimizer.h"
+#include "SbFileWatch.h"
+#include "SbSnapshot.h"
+#include "SbArena.h"
+#include "SbInput.h"
+#include "SbTimerWheel.h"
 
 
 class Ball;
 class Tile;
 class Goal;
 class Level;
+class Autopilot;
 
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 const int LEVEL_WIDTH = 2000;
 const int LEVEL_HEIGHT = 1500;
 const int CONTROLLER_DEADZONE = 6000;
+const SDL_Color TILE_COLOR = {40, 40, 160, 0};
+//! ms between reaching the goal and the next level
+const Uint32 LEVEL_CHANGE_DELAY = 1500;
+//! levels with more tiles are streamed in chunks around the camera
+const uint32_t STREAM_THRESHOLD = 20000;
 const std::string name = "Maze";
 
   
@@ -35,19 +56,32 @@ public:
   Ball(const SbDimension* ref);
 
   bool check_goal(const Goal& goal);
-  void handle_event(const SDL_Event& event);
-  int move(const std::vector<std::unique_ptr<SbObject>>& level);
+  /*! Accelerate for the directions pressed or held in this frame's input.
+   */
+  void control(const SbInputState& input);
+  int move(const SbSpatialGrid& tiles);
   //  void render();
   /*! Reset after goal.
    */
   void reset();
   void set_momentum_loss(double ml) {momentum_loss_ = ml;}
+  void save_state(SbSnapshot& snapshot) const override;
+  void restore_state(SbSnapshot& snapshot) override;
+  //! change of velocity per key press
+  double velocity_step() const { return velocity_; }
   
 private:
+  void accelerate(SbControlDir direction, double sensitivity);
+
   bool goal_ = false;
+  //! time a direction has been held since the last acceleration
+  Uint32 repeat_time_ = 0;
+  Uint32 repeat_ms_ = 30;
   //!  momentum lost in collision = (1-momentum_loss_) * momentum before collision
   double momentum_loss_ = 0.9;
   double velocity_max_ = 1.0/800.0;
+  //! tiles near the ball, reused every move
+  std::vector<SbObject*> nearby_;
 };
 
 
@@ -56,7 +90,12 @@ class Tile : public SbObject
 {
  public:
   Tile(int x, int y, int width, int height, const SbDimension* ref);
-  Tile( SbRectangle bounding_box, const SbDimension* ref );
+  /*! With an arena, the texture and its reference count are kept in there with the tile.
+   */
+  Tile( SbRectangle bounding_box, const SbDimension* ref, SbArena* arena = nullptr );
+  /*! Move and resize the tile, the texture is only redrawn if the size changes.
+   */
+  void reshape( SbRectangle bounding_box );
 };
 
 
@@ -70,19 +109,64 @@ class Goal : public SbObject
 
 
 
+/*! A level copied out of the level file, made without touching SDL so that it can be done on a worker thread.
+ */
+struct LevelLayout
+{
+  uint32_t number = 0;
+  SbDimension dimension;
+  SbRectangle goal;
+  //! merged by SbTileOptimizer, empty for streamed levels
+  std::vector<SbRectangle> tiles;
+  //! number of tiles in the level file
+  uint32_t tiles_in_file = 0;
+  bool stream = false;
+};
+
+
+
 class Level
 {
  public:
-  Level(int num, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref );
+  Level(const SbLevelFile& levels, int num, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref );
+  /*! Level without tiles yet, call build() until it returns true.
+   */
+  Level(const SbLevelFile& levels, LevelLayout layout, std::shared_ptr<TTF_Font> font, const SbDimension* window_ref );
   ~Level() = default;
+  Level(const Level&) = delete;
+  Level& operator=(const Level&) = delete;
   
+  static LevelLayout layout(const SbLevelFile& levels, uint32_t num);
+  /*! Create the tiles and their textures, stopping after budget_ms if budget_ms > 0. Returns true when all tiles are there.
+   */
+  bool build(double budget_ms = 0);
+  bool built() const { return streaming_ || tiles_.size() == layout_.tiles.size(); }
   void create_level(uint32_t num);
+  /*! Switch to an edited version of the level file: compare the current level with the one in levels and only add, remove or reshape the tiles that differ.
+    Returns the number of tiles touched. levels must outlive the Level, as for the constructor.
+   */
+  uint32_t reload(const SbLevelFile& levels);
+  /*! Streamed levels (more than STREAM_THRESHOLD tiles) only hold the tiles of the chunks near the camera, call stream() every frame before moving the ball.
+    Chunks overlapping the camera are always resident, if one is not the call waits for it. Chunks within one chunk around the camera are read on worker threads and their tiles built within the frame budget. When the tiles take more than the memory budget, the least recently used chunks away from the camera are dropped.
+   */
+  void stream(const SDL_Rect& camera);
+  bool streaming() const { return streaming_; }
+  //! tiles in the level file, tiles().size() is the number left after merging
+  uint32_t tiles_in_file() const { return layout_.tiles_in_file; }
+  void set_memory_budget(uint64_t bytes) { memory_budget_ = bytes; }
+  uint64_t resident_bytes() const { return resident_bytes_; }
   void start_timer(){ time_message_.start_timer(); }
   void stop_timer(){ time_message_.stop_timer(); }
   Uint32 time() { return time_message_.time(); }
+  void set_time(Uint32 ms) { time_message_.set_time(ms); }
+  /*! Level number and clock, the tiles do not change during a game.
+   */
+  void save_state(SbSnapshot& snapshot) const;
+  void restore_state(SbSnapshot& snapshot);
     
   Goal const& goal() const {return *goal_;}
-  std::vector<std::unique_ptr<SbObject>> const& tiles() const {return tiles_; }
+  std::vector<SbObject*> const& tiles() const {return tiles_; }
+  SbSpatialGrid const& grid() const {return grid_; }
   uint32_t width() { return dimension_.w; }
   uint32_t height() {return dimension_.h; }
   void render(const SDL_Rect &camera);
@@ -91,78 +175,167 @@ class Level
   const SbDimension* get_dimension() const {return &dimension_;} 
   
  private:
+  //! tiles overlapping a chunk as read by the worker thread
+  struct ChunkData
+  {
+    std::vector<uint32_t> ids;
+    std::vector<SbRectangle> boxes;
+  };
+  
+  struct Chunk
+  {
+    bool resident = false;
+    uint64_t last_used = 0;
+    std::vector<uint32_t> ids;
+    std::future<ChunkData> loading;
+  };
+
+  struct ResidentTile
+  {
+    //! position in tiles_
+    size_t slot;
+    //! number of resident chunks the tile overlaps
+    uint32_t chunks;
+    uint64_t bytes;
+  };
+
+  void start_streaming();
+  void stop_streaming();
+  void load_chunk(uint32_t id, Chunk& chunk);
+  void add_chunk(Chunk& chunk, ChunkData data);
+  void evict_chunk(uint32_t id);
+
+  const SbLevelFile* levels_;
   SbDimension dimension_ = {100,100};
   const SbDimension* window_ref_;
   uint32_t level_num_ = 0;
-  std::unique_ptr<Goal> goal_ = nullptr;
-  std::vector<std::unique_ptr<SbObject>> tiles_;
+  //! owns the tiles and the goal, create_level() resets it in one go
+  SbArena arena_;
+  Goal* goal_ = nullptr;
+  std::vector<SbObject*> tiles_;
+  SbSpatialGrid grid_;
+  //! what build() works through
+  LevelLayout layout_;
   SbMessage time_message_;
+  bool streaming_ = false;
+  SbLevelView view_;
+  std::unordered_map<uint32_t, Chunk> chunks_;
+  std::unordered_map<uint32_t, ResidentTile> resident_;
+  //! tile index in the level file of each entry of tiles_
+  std::vector<uint32_t> tile_ids_;
+  uint64_t memory_budget_ = 64 << 20;
+  uint64_t resident_bytes_ = 0;
+  uint64_t stream_frame_ = 0;
+  size_t n_loading_ = 0;
+  //! chunk reads in flight, on top of the ones the camera waits for
+  size_t max_loading_ = 4;
+  //! time per frame spent on building tiles of loaded chunks
+  double stream_budget_ms_ = 2;
+};
+
+
+/*! Steers the ball to the goal without a player, e.g. for soak tests.
+  plan() finds a route on a grid of ball-sized cells from the ball to the goal, steer() adds direction presses to the frame's input to follow it, so the ball moves with the same velocity model as under a player.
+ */
+class Autopilot
+{
+ public:
+  void plan(const Level& level, const Ball& ball);
+  void steer(Ball& ball, SbInputState& input);
+
+ private:
+  void push(Ball& ball, SbInputState& input, int distance, int tolerance, double velocity, double scale, SbAction decrease, SbAction increase);
+
+  const Level* level_ = nullptr;
+  //! way points for the ball centre, level coordinates
+  std::vector<SDL_Point> route_;
+  size_t next_ = 0;
+  //! re-plan if no way point was reached for this long, e.g. after bouncing off a wall
+  Uint32 stuck_time_ = 3000;
+  SbTimer progress_;
+  //! cruising speed in pixel/ms
+  double max_speed_ = 0.4;
 };
 
 
 class Maze
 {
  public:
-  Maze();
+  /*! Highscores go to savefile. An empty name keeps them in memory and never touches a file, e.g. for the sessions of an SbBatchRunner.
+   */
+  Maze(const std::string& level_file = "resources/maze.lvl", const std::string& savefile = "maze.save");
   ~Maze();
   Maze(const Maze&)  = delete ;
   Maze& operator=(const Maze& toCopy) = delete;
 
   void initialize();
   void reset();
-  static Uint32 reset_game(Uint32 interval, void *param );
   void run();
+  /*! One pass of the game loop: poll events, move, render.
+   */
+  void frame();
+  //! quit was asked for, run() returns after this frame
+  bool done() const { return quit_; }
+  SbEventSource* events() {return &events_; }
+  SbFrameWatchdog* watchdog() {return &watchdog_; }
+  /*! Let the Autopilot play, looping through the levels until quit.
+   */
+  void set_autopilot(bool on);
+  /*! Reload the level file whenever it changes on disk, e.g. after make levels.
+   */
+  void watch_levels(bool on);
+  void reload_levels();
+  /*! Memory for the tiles of a streamed level, see Level::stream.
+   */
+  void set_memory_budget(uint64_t bytes);
+  /*! Start preparing the level after the current one: layout on a worker thread, then textures a few at a time in frame() while the goal delay runs.
+   */
+  void prepare_next_level();
+  void cancel_next_level();
+  /*! Everything that changes while playing a level: level number and clock, ball, goal state. restore() throws if the snapshot is of another level.
+   */
+  void snapshot(SbSnapshot& snapshot) const;
+  void restore(SbSnapshot& snapshot);
   SbWindow* window() {return &window_; }
+  SbGameContext* context() {return &context_; }
   
  private:
 
+  //! first, so that it outlives everything that draws or times with it
+  SbGameContext context_;
   std::unique_ptr<Ball> ball_;
+  std::unique_ptr<Autopilot> autopilot_ = nullptr;
+  std::unique_ptr<SbLevelFile> levels_ = nullptr;
+  std::unique_ptr<SbFileWatch> level_watch_ = nullptr;
+  //! reads levels_, declared after it so that it is waited for before levels_ goes away
+  std::future<LevelLayout> next_layout_;
+  std::unique_ptr<Level> next_level_ = nullptr;
+  //! time per frame spent on textures for next_level_
+  double prepare_budget_ms_ = 2;
+  uint64_t memory_budget_ = 64 << 20;
+  SbFont font_;
   std::unique_ptr<Level> level_ = nullptr;
   SDL_GameController* game_controller_ = nullptr;
   bool in_goal_ = false;
+  bool quit_ = false;
   uint32_t current_level_ = 0;
   SbWindow window_{name, SCREEN_WIDTH, SCREEN_HEIGHT};
   SDL_Rect camera_;
+  SbEventSource events_;
+  SbInput input_;
+  SbFrameWatchdog watchdog_;
   std::unique_ptr<SbFpsDisplay> fps_display_ = nullptr;
-  SbTimer reset_timer_;
+  std::unique_ptr<SbRenderStatsDisplay> render_stats_ = nullptr;
+  //! delayed work, run on the game loop at the start of the update phase
+  SbTimerWheel timers_;
+  //! starts the next level after the goal delay
+  SbTimerWheel::Handle level_change_ = 0;
   std::unique_ptr<SbHighScore> highscore_ = nullptr;
+  std::string savefile_;
+  //! a snapshot every frame, for rewinding with backspace
+  SbRewindBuffer rewind_;
+  SbSnapshot snapshot_;
 };
 
 
-struct LevelCoordinates
-{
-LevelCoordinates(SbDimension d, std::vector<SbRectangle> t, SbRectangle g)
-: tiles(t),goal(g), dimension(d)
-  {}
-  std::vector<SbRectangle> tiles;
-  SbRectangle goal;
-  SbDimension dimension;
-};
-
-
-////////////////////
-////// levels //////
-////////////////////
-std::vector<LevelCoordinates> levels;
-
-std::vector<SbRectangle> lev0 = {{0,0,1.0,0.05}, {0.95,0.0,0.05,1.0}, {0.0,0.,0.05,1.0}, {0.0, 0.95, 1.0, 0.05}  /* outer boxes */
-				 , {0.45,0.45,0.1,0.1},{0.35,0.35,0.1,0.1}, {0.55,0.35,0.1,0.1}, {0.55,0.55,0.1,0.1}, {0.35,0.55,0.1,0.1}    /* central boxes */ 
-				 ,{ 0.85, 0.4, 0.03, 0.53 }	/* barrier next to goal*/				      
-	};
-SbRectangle goal0 = {0.4, 0.48, 0.03, 0.03};
-SbDimension dim0 = {LEVEL_WIDTH, LEVEL_HEIGHT};
-
-std::vector<SbRectangle> lev1 = {{0,0,1.0,0.03}, {0.97,0.0,0.03,1.0}, {0.0,0.,0.03,1.0}, {0.0, 0.97, 1.0, 0.03}  /* outer boxes */
-				 , {0.15,0.85,0.18,0.03}, {0.4, 0.85, 0.52, 0.03} /* lower horiz. bars */
-				 , {0.2, 0.2, 0.03, 0.6}, {0.6, 0.0, 0.03, 0.4}  /* vert. bars */
-				 , {0.45, 0.6, 0.55, 0.03}   /* middle horiz. bar */
-};
-SbRectangle goal1 = {0.85, 0.1, 0.03, 0.03};
-SbDimension dim1 = {LEVEL_WIDTH, LEVEL_HEIGHT};
-////////////////////
-//// levels end ////
-////////////////////
-
-
-
 #endif  // SBMAZE_H
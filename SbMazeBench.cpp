@@ -0,0 +1,93 @@
+/*! \file SbMazeBench.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+
+  Benchmarks of the Maze: Ball::move, Level::create_level and a one-tile Level::reload over synthetic levels of growing size, SbMazeGenerator, a rewind snapshot and a full headless frame.
+  Links SbMaze.o built with -DSB_NO_MAIN.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+#include "SbWindow.h"
+#include "SbFont.h"
+#include "SbBench.h"
+#include "SbLevelFile.h"
+#include "SbMazeGenerator.h"
+
+#include "SbMaze.h"
+
+
+/*! n_tiles boxes on a regular grid covering the level, away from the ball start position.
+ */
+static SbLevelData
+synthetic_level(uint32_t n_tiles)
+{
+  SbLevelData level;
+  level.dimension = SbDimension{LEVEL_WIDTH, LEVEL_HEIGHT};
+  level.goal = SbRectangle{0.4, 0.48, 0.03, 0.03};
+  uint32_t columns = std::ceil( std::sqrt(n_tiles) );
+  double step = 0.8 / columns;
+  for ( uint32_t i = 0; i < n_tiles; ++i )
+    level.tiles.emplace_back( 0.05 + (i % columns) * step, 0.05 + (i / columns) * step, step/2, step/2 );
+  return level;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+  SbBench bench("maze");
+  bench_init(bench, argc, argv);
+  try {
+    Maze maze;
+    SbFont font("resources/FreeSans.ttf", 120 );
+    const SbDimension* window_ref = maze.window()->get_dimension();
+
+    run_core_benchmarks(bench, font.font(), window_ref);
+
+    const std::vector<uint32_t> sizes = {16, 64, 256, 1024, 4096};
+    std::vector<SbLevelData> data;
+    for ( uint32_t n_tiles: sizes )
+      data.push_back( synthetic_level(n_tiles) );
+    SbLevelFile::write( "bench_maze.lvl", data );
+    SbLevelFile levels( "bench_maze.lvl" );
+
+    // the same levels with one tile moved, for hot reloads
+    for ( auto& level: data )
+      level.tiles.front().x += 0.01;
+    SbLevelFile::write( "bench_maze_edit.lvl", data );
+    SbLevelFile edited( "bench_maze_edit.lvl" );
+
+    for ( uint32_t num = 0; num < sizes.size(); ++num ) {
+      uint32_t n_tiles = sizes.at(num);
+      Level level(levels, num, font.font(), window_ref);
+      Ball ball(level.get_dimension());
+      bench.run("ball_move", n_tiles, [&]() { SbBench::keep( ball.move(level.grid()) ); } );
+      bench.run("level_create_level", n_tiles, [&]() { level.create_level(num); } );
+      bool toggle = false;
+      bench.run("level_reload_one_tile", n_tiles, [&]() { toggle = !toggle; SbBench::keep( level.reload( toggle ? edited : levels ) ); } );
+    }
+
+    for ( uint32_t n_cells: {10, 100, 1000} ) {
+      SbMazeGenerator generator( n_cells, n_cells, 1 );
+      bench.run("maze_generate", n_cells * n_cells, [&]() { SbBench::keep( generator.generate().tiles.size() ); } );
+    }
+
+    SbSnapshot snapshot;
+    SbRewindBuffer rewind;
+    bench.run("snapshot", 1, [&]() { maze.snapshot(snapshot); rewind.push(snapshot); } );
+    bench.run("frame", 1, [&]() { maze.frame(); } );
+    std::remove( "bench_maze.lvl" );
+    std::remove( "bench_maze_edit.lvl" );
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    sdl_quit();
+    return 1;
+  }
+  sdl_quit();
+  return 0;
+}
@@ -0,0 +1,147 @@
+/*! \file SbMazeGenerator.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <algorithm>
+
+#include "SbMazeGenerator.h"
+
+
+SbMazeGenerator::SbMazeGenerator(uint32_t columns, uint32_t rows, uint32_t seed)
+  : columns_(columns), rows_(rows), seed_(seed)
+{
+  if ( columns_ == 0 || rows_ == 0 )
+    throw std::runtime_error("[SbMazeGenerator::SbMazeGenerator] Error: maze needs at least one cell, got " + std::to_string(columns) + "x" + std::to_string(rows) );
+}
+
+
+
+uint32_t
+SbMazeGenerator::next_random()
+{
+  // xorshift32, the standard distributions are not the same on every platform
+  state_ ^= state_ << 13;
+  state_ ^= state_ >> 17;
+  state_ ^= state_ << 5;
+  return state_;
+}
+
+
+
+SbLevelData
+SbMazeGenerator::generate()
+{
+  if ( passage <= 0 || wall <= 0 || max_tile_length < wall )
+    throw std::runtime_error("[SbMazeGenerator::generate] Error: invalid passage, wall or tile length" );
+  const uint64_t width = uint64_t(columns_) * ( passage + wall ) + wall;
+  const uint64_t height = uint64_t(rows_) * ( passage + wall ) + wall;
+  if ( width > uint64_t(std::numeric_limits<int>::max()) || height > uint64_t(std::numeric_limits<int>::max()) )
+    throw std::runtime_error("[SbMazeGenerator::generate] Error: maze too large" );
+  state_ = seed_ * 2654435761u + 1;
+  if ( state_ == 0 )
+    state_ = 1;
+
+  // blocks: walls between and around the cells, cell (c,r) is block (2c+1,2r+1)
+  const uint32_t block_columns = 2 * columns_ + 1;
+  const uint32_t block_rows = 2 * rows_ + 1;
+  std::vector<uint8_t> solid( uint64_t(block_columns) * block_rows, 1 );
+  auto block = [block_columns](uint32_t column, uint32_t row) { return uint64_t(row) * block_columns + column; };
+
+  // start in the cell the ball starts in
+  uint32_t start_column = std::min<uint32_t>( start.x * width / ( passage + wall ), columns_ - 1 );
+  uint32_t start_row = std::min<uint32_t>( start.y * height / ( passage + wall ), rows_ - 1 );
+  std::vector<uint8_t> visited( uint64_t(columns_) * rows_, 0 );
+  std::vector<uint32_t> stack;
+  uint32_t goal_cell = start_row * columns_ + start_column;
+  size_t goal_depth = 0;
+  stack.push_back( goal_cell );
+  visited[ goal_cell ] = 1;
+  solid[ block( 2*start_column + 1, 2*start_row + 1 ) ] = 0;
+  while ( !stack.empty() ) {
+    uint32_t cell = stack.back();
+    uint32_t column = cell % columns_, row = cell / columns_;
+    uint32_t candidates[4];
+    uint32_t n_candidates = 0;
+    if ( column > 0 && !visited[ cell - 1 ] )
+      candidates[ n_candidates++ ] = cell - 1;
+    if ( column + 1 < columns_ && !visited[ cell + 1 ] )
+      candidates[ n_candidates++ ] = cell + 1;
+    if ( row > 0 && !visited[ cell - columns_ ] )
+      candidates[ n_candidates++ ] = cell - columns_;
+    if ( row + 1 < rows_ && !visited[ cell + columns_ ] )
+      candidates[ n_candidates++ ] = cell + columns_;
+    if ( n_candidates == 0 ) {
+      stack.pop_back();
+      continue;
+    }
+    uint32_t next = candidates[ next_random() % n_candidates ];
+    uint32_t next_column = next % columns_, next_row = next / columns_;
+    // open the wall between the cells and the next cell itself
+    solid[ block( column + next_column + 1, row + next_row + 1 ) ] = 0;
+    solid[ block( 2*next_column + 1, 2*next_row + 1 ) ] = 0;
+    visited[ next ] = 1;
+    stack.push_back( next );
+    if ( stack.size() > goal_depth ) {
+      goal_depth = stack.size();
+      goal_cell = next;
+    }
+  }
+
+  // clear the start area, but keep the outer wall
+  int start_x = start.x * width, start_y = start.y * height;
+  for ( uint32_t row = 1; row + 1 < block_rows; ++row ) {
+    if ( position(row) + length(row) < start_y - start_size/2 || position(row) > start_y + start_size )
+      continue;
+    for ( uint32_t column = 1; column + 1 < block_columns; ++column ) {
+      if ( position(column) + length(column) >= start_x - start_size/2 && position(column) <= start_x + start_size )
+	solid[ block( column, row ) ] = 0;
+    }
+  }
+
+  SbLevelData level;
+  level.dimension = SbDimension( width, height );
+  // boxes are stored as fractions, half a pixel in so that SbObject rounds back to the same pixel
+  auto box = [&level](int x, int y, int w, int h) {
+    return SbRectangle( ( x + 0.5 ) / level.dimension.w, ( y + 0.5 ) / level.dimension.h
+			, ( w + 0.5 ) / level.dimension.w, ( h + 0.5 ) / level.dimension.h );
+  };
+  uint32_t goal_column = 2 * ( goal_cell % columns_ ) + 1, goal_row = 2 * ( goal_cell / columns_ ) + 1;
+  level.goal = box( position(goal_column) + passage/4, position(goal_row) + passage/4, passage/2, passage/2 );
+
+  // greedy merging: grow each rectangle right, then down, as long as it only covers unused wall blocks
+  wall_cells_ = 0;
+  for ( uint8_t b: solid )
+    wall_cells_ += b;
+  std::vector<uint8_t>& free = solid;   // 1: wall block not yet in a tile
+  for ( uint32_t row = 0; row < block_rows; ++row ) {
+    for ( uint32_t column = 0; column < block_columns; ++column ) {
+      if ( !free[ block(column, row) ] )
+	continue;
+      uint32_t last_column = column;
+      while ( last_column + 1 < block_columns && free[ block(last_column + 1, row) ]
+	      && position(last_column + 1) + length(last_column + 1) - position(column) <= max_tile_length )
+	++last_column;
+      uint32_t last_row = row;
+      while ( last_row + 1 < block_rows
+	      && position(last_row + 1) + length(last_row + 1) - position(row) <= max_tile_length ) {
+	bool full = true;
+	for ( uint32_t c = column; c <= last_column && full; ++c )
+	  full = free[ block(c, last_row + 1) ];
+	if ( !full )
+	  break;
+	++last_row;
+      }
+      for ( uint32_t r = row; r <= last_row; ++r )
+	for ( uint32_t c = column; c <= last_column; ++c )
+	  free[ block(c, r) ] = 0;
+      level.tiles.push_back( box( position(column), position(row)
+				  , position(last_column) + length(last_column) - position(column)
+				  , position(last_row) + length(last_row) - position(row) ) );
+    }
+  }
+  return level;
+}
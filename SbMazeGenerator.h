@@ -0,0 +1,53 @@
+/*! \file SbMazeGenerator.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBMAZEGENERATOR_H
+#define SBMAZEGENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "SbLevelFile.h"
+
+
+/*! Makes Maze levels of any size from a seed, the same seed gives the same level on every platform.
+  The maze is carved by a recursive backtracker (iterative, with an explicit stack) on a grid of columns x rows cells, every cell is reachable from every other one by exactly one path. The goal goes into the cell farthest from the start along the carving. The wall cells are then merged into maximal rectangles, so a level has far fewer tiles than wall cells.
+  The area where the Ball starts (start, fractions of the level size) is kept clear of walls.
+ */
+class SbMazeGenerator
+{
+ public:
+  SbMazeGenerator(uint32_t columns, uint32_t rows, uint32_t seed);
+
+  SbLevelData generate();
+  //! wall cells before merging, of the last generate()
+  uint64_t wall_cells() const { return wall_cells_; }
+
+  //! width of the passages in pixels
+  int passage = 60;
+  //! thickness of the walls in pixels
+  int wall = 20;
+  //! tiles are at most this long in pixels, keeps textures small and tiles in few chunks
+  int max_tile_length = SbLevelFile::chunk_size;
+  //! kept free of walls, fractions of the level size
+  SbRectangle start = {0.9, 0.92, 0.0, 0.0};
+  //! size of the start area in pixels
+  int start_size = 40;
+
+ private:
+  //! position and size in pixels of the n-th block along an axis, blocks alternate wall and passage
+  int position(uint32_t block) const { return ( block / 2 ) * ( passage + wall ) + ( block % 2 ) * wall; }
+  int length(uint32_t block) const { return ( block % 2 ) ? passage : wall; }
+  uint32_t next_random();
+
+  uint32_t columns_;
+  uint32_t rows_;
+  uint32_t seed_;
+  uint32_t state_ = 0;
+  uint64_t wall_cells_ = 0;
+};
+
+
+#endif  // SBMAZEGENERATOR_H
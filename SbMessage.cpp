@@ -9,6 +9,8 @@
 #include <iomanip>
 
 #include "SbTexture.h"
+#include "SbRenderStats.h"
+#include "SbEventSource.h"
 #include "SbWindow.h"
 
 #include "SbMessage.h"
@@ -27,7 +29,7 @@ SbMessage::set_text(std::string message)
   if ( !font_)
     throw std::runtime_error( "[SbMessage::set_text] no font. Call set_font before setting the text." );
 
-  texture_->from_text( window->renderer(), message, font_.get(), color_);
+  texture_->from_text( window()->renderer(), message, font_.get(), color_);
 }
 
 
@@ -46,7 +48,7 @@ void
 SbFpsDisplay::handle_event(const SDL_Event& event)
 {
   if ( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_f ) {
-    const Uint8 *state = SDL_GetKeyboardState(nullptr);
+    const Uint8 *state = SbEventSource::keyboard_state();
     if (state[SDL_SCANCODE_LALT]){
       render_me_ = !render_me_;
     }
@@ -76,7 +78,54 @@ SbFpsDisplay::update()
     times_.pop_front();
   }
   double average = 1000 * times_.size() / sum_ ;
-  set_text( std::to_string( int(average) ) + " fps" );
+  std::string text = std::to_string( int(average) ) + " fps";
+  // only re-render the text when it changed, as SbRenderStatsDisplay does
+  if ( text != text_ ) {
+    text_ = text;
+    set_text( text_ );
+  }
+}
+
+
+/*! SbRenderStatsDisplay implementation
+ */
+SbRenderStatsDisplay::SbRenderStatsDisplay(std::shared_ptr<TTF_Font> font, SbRectangle box, const SbDimension* ref)
+  : SbMessage(box, ref)
+{
+  name_ = "renderstats";
+  set_font(font);
+  render_me_ = false;
+}
+
+
+void
+SbRenderStatsDisplay::handle_event(const SDL_Event& event)
+{
+  if ( event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_r ) {
+    const Uint8 *state = SbEventSource::keyboard_state();
+    if (state[SDL_SCANCODE_LALT]){
+      render_me_ = !render_me_;
+    }
+  }
+}
+
+
+void
+SbRenderStatsDisplay::update()
+{
+  if ( !render_me_ )
+    return;
+  const SbRenderCounters& stats = SbRenderStats::last_frame();
+  std::ostringstream strstr;
+  strstr << "copies " << stats.render_copies
+	 << "  tex +" << stats.textures_created << "/-" << stats.textures_destroyed
+	 << "  targets " << stats.target_switches
+	 << "  " << std::fixed << std::setprecision(1) << stats.texture_bytes / (1024.0*1024.0) << " MB" ;
+  // only re-render the text when it changed, otherwise the overlay would show up in its own counters every frame
+  if ( strstr.str() != text_ ) {
+    text_ = strstr.str();
+    set_text( text_ );
+  }
 }
 
 
@@ -86,15 +135,14 @@ SbHighScore::SbHighScore(std::shared_ptr<TTF_Font> font, SbRectangle box, const
   : SbMessage(box, ref)
 {
   font_ = font;
-  name_ = "gameover" ;  //!< same name to render only when game over.
-  read_highscores();
-  //  highscores_.push_back(0);
+  name_ = "highscore" ;
 }
 
 
 bool
 SbHighScore::check_highscore(uint32_t score, bool(SbHighScore::*fctn)(uint32_t, uint32_t), uint32_t level, double multiplier)
 {
+  read_highscores();
   bool result = false;
   if ( level >= highscores_.size() ) {
     while ( level > highscores_.size() )
@@ -110,7 +158,7 @@ SbHighScore::check_highscore(uint32_t score, bool(SbHighScore::*fctn)(uint32_t,
   }
   std::ostringstream strstr;
   if (result) {
-    write_highscores();
+    store_->set( level, score );
     strstr << "*** New record: " << std::fixed << std::setprecision(precision_) << score * multiplier << postfix << " ***" ; 
   }
   else {
@@ -136,40 +184,13 @@ SbHighScore::higher(uint32_t score, uint32_t level)
 
 
 
-void
-SbHighScore::write_highscores( )
-{
-  SDL_RWops* file = SDL_RWFromFile( savefile.c_str() , "w+b" );
-  if ( !file ) {
-    throw std::runtime_error("[SbHighScore::write_highscores] Error: Couldn't open file " + savefile + ":\n" + SDL_GetError() );
-  }
-  uint32_t size = highscores_.size();
-  SDL_RWwrite( file, &size, sizeof(uint32_t), 1 );
-  for ( auto score: highscores_ ) {
-    SDL_RWwrite( file, &score, sizeof(uint32_t), 1 );
-  }
-  SDL_RWclose( file );
-  // std::cout << "[SbHighScore::write_highscores] " ;
-  // std::ostream_iterator<uint32_t> iter(std::cout);
-  // std::copy(highscores_.begin(), highscores_.end(), iter);
-}
-
-
 std::vector<uint32_t>
 SbHighScore::read_highscores( )
 {
-  SDL_RWops* file = SDL_RWFromFile( savefile.c_str() , "rb" );
-  if ( file ) {
-    uint32_t max = 0;
-    SDL_RWread( file, &max, sizeof(uint32_t), 1 );
-    uint32_t scores[max];
-    SDL_RWread( file, &scores, sizeof(uint32_t), max );
-    highscores_.assign( &scores[0], &scores[0]+max );
-    SDL_RWclose( file );
+  if ( !store_ || store_->filename() != savefile ) {
+    store_.reset();
+    store_ = std::unique_ptr<SbHighScoreStore>( new SbHighScoreStore( savefile ) );
+    highscores_ = store_->scores();
   }
-  // std::cout << "[SbHighScore::read_highscores] " ;
-  // std::ostream_iterator<uint32_t> iter(std::cout);
-  // std::copy(highscores_.begin(), highscores_.end(), iter);
   return highscores_;
 }
-
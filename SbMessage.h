@@ -11,6 +11,7 @@
 #include <SDL2/SDL_ttf.h>
 
 #include "SbObject.h"
+#include "SbHighScoreStore.h"
 
 
 class SbMessage : public SbObject
@@ -40,19 +41,37 @@ class SbFpsDisplay : public SbMessage
   uint32_t n_frames_ = 250;
   double sum_ = 0;
   std::deque<double> times_;
+  std::string text_;
   
 };
 
 
+/*! Overlay showing the SbRenderStats counters of the previous frame. Hidden by default, toggle with left-alt+r.
+ */
+class SbRenderStatsDisplay : public SbMessage
+{
+ public:
+  SbRenderStatsDisplay(std::shared_ptr<TTF_Font> font, SbRectangle box, const SbDimension* ref);
+  void handle_event(const SDL_Event& event) override;
+  void update();
+
+ private:
+  std::string text_;
+};
+
+
 class SbHighScore : public SbMessage
 {
  public:
   //  SbHighScore(std::shared_ptr<TTF_Font> font, std::string filename = "game.save", std::string prefix = "Your result", std::string postfix = "" );
   SbHighScore(std::shared_ptr<TTF_Font> font, SbRectangle box, const SbDimension* ref);
+  /*! A new record is handed to the SbHighScoreStore of savefile, which writes it in the background.
+   */
   bool check_highscore( uint32_t score, bool(SbHighScore::*fctn)(uint32_t, uint32_t), uint32_t level = 0, double multiplier = 1.0);
   std::vector<uint32_t> highscores() { return highscores_; }
+  /*! Opens savefile if it is not open yet (savefile is usually set after construction) and returns its scores.
+   */
   std::vector<uint32_t> read_highscores( );
-  void write_highscores( );
 
   bool higher(uint32_t score, uint32_t level);
   bool lower(uint32_t score, uint32_t level);
@@ -63,6 +82,7 @@ class SbHighScore : public SbMessage
 
  private:
   std::vector<uint32_t> highscores_;
+  std::unique_ptr<SbHighScoreStore> store_ = nullptr;
   uint32_t precision_ = 1;
 };
 
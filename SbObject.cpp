@@ -8,12 +8,11 @@
 
 #include "SbTexture.h"
 #include "SbWindow.h"
+#include "SbSnapshot.h"
 
 #include "SbObject.h"
 
 
-SbWindow* SbObject::window;
-
 SbObject::SbObject( SbRectangle bounding_box, const SbDimension* ref)
   : reference_(ref), bounding_box_(bounding_box)
 {
@@ -41,8 +40,8 @@ SbObject::SbObject( SDL_Rect bounding_rect, const SbDimension* ref)
 void
 SbObject::center_camera(SDL_Rect& camera, int w, int h) 
 {
-  camera.w = window->width();
-  camera.h = window->height();
+  camera.w = window()->width();
+  camera.h = window()->height();
   camera.x = pos_x() + width()/2 - camera.w/2;
   camera.y = pos_y() + height()/2 - camera.h/2;
   if ( camera.x < 0 )
@@ -60,9 +59,16 @@ SbObject::center_camera(SDL_Rect& camera, int w, int h)
 
 SbHitPosition
 SbObject::check_hit(const SbObject& toHit)
+{
+  return check_hit( toHit.bounding_rect() );
+}
+
+
+
+SbHitPosition
+SbObject::check_hit(const SDL_Rect& hit_box) const
 {
   SbHitPosition result = SbHitPosition::none;
-  const SDL_Rect& hit_box = toHit.bounding_rect();
   bool in_xrange = false, in_yrange = false, x_hit_left = false, x_hit_right = false, y_hit_top = false, y_hit_bottom = false ;
 
   if ( bounding_rect_.x + (bounding_rect_.w)/2  >= hit_box.x &&
@@ -168,7 +174,7 @@ SbObject::print_dimensions(std::ostream& os)
 void
 SbObject::render()
 {
-  if (render_me_ && texture_) texture_->render( window->renderer(), &bounding_rect_ );
+  if (render_me_ && texture_) texture_->render( window()->renderer(), &bounding_rect_ );
 }
 
 
@@ -179,7 +185,7 @@ SbObject::render( const SDL_Rect &camera )
     SDL_Rect camera_adjusted = bounding_rect_;
     camera_adjusted.x -= camera.x;
     camera_adjusted.y -= camera.y;
-    texture_->render( window->renderer(), &camera_adjusted );
+    texture_->render( window()->renderer(), &camera_adjusted );
   }
 }
 
@@ -200,3 +206,32 @@ SbObject::was_hit()
   std::cout << "[SbObject::was_hit]" << std::endl;
 #endif
 }
+
+
+
+void
+SbObject::save_state(SbSnapshot& snapshot) const
+{
+  snapshot.write( bounding_rect_ );
+  snapshot.write( bounding_box_ );
+  snapshot.write( velocity_x_ );
+  snapshot.write( velocity_y_ );
+  snapshot.write( timer_.get_time() );
+  snapshot.write( timer_.started() );
+}
+
+
+
+void
+SbObject::restore_state(SbSnapshot& snapshot)
+{
+  snapshot.read( bounding_rect_ );
+  snapshot.read( bounding_box_ );
+  snapshot.read( velocity_x_ );
+  snapshot.read( velocity_y_ );
+  Uint32 time = 0;
+  bool started = false;
+  snapshot.read( time );
+  snapshot.read( started );
+  timer_.set_time( time, started );
+}
@@ -10,13 +10,19 @@
 #include <iostream>
 #include <array>
 #include <memory>
+#include <cstdint>
 
 #include <SDL2/SDL.h>
 
 #include "SbTimer.h"
+#include "SbGameContext.h"
 
 class SbTexture;
 class SbWindow;
+class SbSnapshot;
+
+//! tag every object starts with, games define their own tags from bit 1 on
+const uint32_t SB_TAG_DEFAULT = 1u;
 
 enum class SbHitPosition {
   none, top, bottom, left, right
@@ -62,16 +68,22 @@ public:
   SbObject( SbRectangle bounding_box, const SbDimension* ref);
   SbObject( SDL_Rect bounding_rect, const SbDimension* ref);
   
-static SbWindow* window;
+  //! the window of the current SbGameContext
+  static SbWindow* window() { return SbGameContext::current().window; }
  
  void center_camera(SDL_Rect& camera, int width, int height) ;
  SbHitPosition check_hit(const SbObject& toHit);
+ SbHitPosition check_hit(const SDL_Rect& hit_box) const;
  virtual void handle_event(const SDL_Event& event){}
   virtual int move( );
   virtual void render() ;
   virtual void render(const SDL_Rect &camera);
   virtual void update_size();
   virtual void was_hit();
+  /*! Write the fields that change during a game (position, velocity, timer) to snapshot, restore_state() reads them back in the same order. Derived objects with more state add theirs after calling these.
+   */
+  virtual void save_state(SbSnapshot& snapshot) const;
+  virtual void restore_state(SbSnapshot& snapshot);
 
   SbRectangle bounding_box() { return bounding_box_;};
   SDL_Rect bounding_rect() const {return bounding_rect_;}
@@ -79,12 +91,22 @@ static SbWindow* window;
   bool is_inside(int x, int y);
   void move_bounding_box();
   void move_bounding_rect();
-  std::string name(){return name_;}
+  const std::string& name() const {return name_;}
+  /*! Drawing order and visibility for SbDrawList: lower layers are drawn first, an object is drawn when its tags share a bit with the mask the list is rendered with. Tell the list (SbDrawList::update()) after changing either.
+   */
+  int layer() const { return layer_; }
+  uint32_t tags() const { return tags_; }
+  void set_layer(int layer) { layer_ = layer; }
+  void set_tags(uint32_t tags) { tags_ = tags; }
   std::ostream& print_dimensions(std::ostream& os); 
   void start_timer() {timer_.start();}
   void stop_timer() {timer_.stop();}
   void set_color( int red, int green, int blue );
+  /*! Size the object relative to ref from now on, e.g. when the level it lives in is replaced. Takes effect with the next update_size().
+   */
+  void set_reference(const SbDimension* ref) { reference_ = ref; }
   Uint32 time() {return timer_.get_time();}
+  void set_time(Uint32 ms) { timer_.set_time( ms, timer_.started() ); }
   bool timer_started() { return timer_.started(); }
   int width() const { return bounding_rect_.w;}
   int height() const { return bounding_rect_.h;}
@@ -111,6 +133,8 @@ protected:
   SDL_Color color_ = {210, 160, 10, 0};
   SbTimer timer_;
   std::string name_ = "other";
+  int layer_ = 0;
+  uint32_t tags_ = SB_TAG_DEFAULT;
   bool has_mouse_ = false;
   bool render_me_ = true;
 };
@@ -0,0 +1,72 @@
+/*! \file SbOptions.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+
+#include "SbEventSource.h"
+#include "SbFrameWatchdog.h"
+#include "SbWindow.h"
+
+#include "SbOptions.h"
+
+
+bool
+SbOptions::parse(int& i, int argc, char* argv[])
+{
+  std::string arg = argv[i];
+  if ( arg == "--headless" )
+    headless = true;
+  else if ( arg == "--render-thread" )
+    render_thread = true;
+  else if ( arg == "--record" || arg == "--replay" ) {
+    if ( i + 1 >= argc )
+      throw std::runtime_error("[SbOptions::parse] Error: " + arg + " needs a file name");
+    ( arg == "--record" ? record : replay ) = argv[++i];
+  }
+  else if ( arg == "--batch" || arg == "--ticks" ) {
+    if ( i + 1 >= argc )
+      throw std::runtime_error("[SbOptions::parse] Error: " + arg + " needs a number");
+    if ( arg == "--batch" )
+      batch = std::stoul( argv[++i] );
+    else
+      ticks = std::stoull( argv[++i] );
+  }
+  else if ( arg == "--frame-budget" || arg == "--hitch-log" ) {
+    if ( i + 1 >= argc )
+      throw std::runtime_error("[SbOptions::parse] Error: " + arg + " needs a value");
+    if ( arg == "--frame-budget" )
+      frame_budget = std::stod( argv[++i] );
+    else
+      hitch_log = argv[++i];
+  }
+  else
+    return false;
+  return true;
+}
+
+
+
+void
+SbOptions::apply(SbEventSource& events, SbFrameWatchdog& watchdog, SbWindow& window) const
+{
+  if ( batch > 0 && !record.empty() )
+    throw std::runtime_error("[SbOptions::apply] Error: batch sessions can not record");
+  watchdog.set_budget(frame_budget);
+  watchdog.set_log(hitch_log);
+  if ( !replay.empty() )
+    events.replay(replay);
+  else if ( !record.empty() )
+    events.record(record);
+  if ( render_thread && batch == 0 )
+    window.set_render_thread(true);
+}
+
+
+
+std::string
+SbOptions::usage()
+{
+  return "[--headless] [--render-thread] [--record file | --replay file] [--frame-budget ms] [--hitch-log file] [--batch n [--ticks n]]";
+}
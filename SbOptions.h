@@ -0,0 +1,44 @@
+/*! \file SbOptions.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBOPTIONS_H
+#define SBOPTIONS_H
+
+#include <string>
+
+class SbEventSource;
+class SbFrameWatchdog;
+class SbWindow;
+
+
+/*! Command line options shared by all games.
+ */
+struct SbOptions
+{
+  bool headless = false;
+  std::string record;
+  std::string replay;
+  //! frame budget of the SbFrameWatchdog in ms, 0 = off
+  double frame_budget = 0;
+  std::string hitch_log = "hitches.log";
+  //! present frames on an SbRenderThread
+  bool render_thread = false;
+  //! headless sessions to run side by side on an SbBatchRunner, 0 = play normally
+  unsigned batch = 0;
+  //! frames per batch session, 0 = until the replay ends
+  uint64_t ticks = 0;
+
+  /*! Reads argv[i] if it is one of the common options, advancing i past its value.
+    \retval false if argv[i] is not a common option
+   */
+  bool parse(int& i, int argc, char* argv[]);
+  /*! Starts recording or replay on the game's event source, configures its watchdog and, if asked for, starts the window's render thread. Batch sessions can only replay and do without a render thread.
+   */
+  void apply(SbEventSource& events, SbFrameWatchdog& watchdog, SbWindow& window) const;
+  static std::string usage();
+};
+
+
+#endif  // SBOPTIONS_H
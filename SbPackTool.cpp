@@ -0,0 +1,39 @@
+/*! \file SbPackTool.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+
+  Packs resource files into a resource pack read by SbResourcePack.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "SbResourcePack.h"
+
+
+int main(int argc, char* argv[])
+{
+  if ( argc < 3 ) {
+    std::cerr << "usage: " << argv[0] << " <resources.pack> <file> [file ...]" << std::endl;
+    return 1;
+  }
+  try {
+    std::string output = argv[1];
+    std::vector<std::string> files( argv + 2, argv + argc );
+    SbResourcePack::write( output, files );
+    SbResourcePack check( output );
+    for ( const std::string& file: files ) {
+      size_t size = 0;
+      if ( !check.find( file, size ) )
+	throw std::runtime_error("[SbPackTool] Error: " + file + " missing from " + output );
+    }
+    std::cout << "wrote " << check.size() << " files to " << output << std::endl;
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,229 @@
+/*! \file SbPixelCache.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <SDL2/SDL_image.h>
+
+#include "SbRenderStats.h"
+#include "SbResourcePack.h"
+
+#include "SbPixelCache.h"
+
+
+std::string SbPixelCache::directory_ = "cache";
+std::atomic<uint64_t> SbPixelCache::hits_{0};
+std::atomic<uint64_t> SbPixelCache::misses_{0};
+
+namespace {
+  const char magic[4] = {'S','B','P','X'};
+}
+
+
+
+uint64_t
+SbPixelCache::hash(const uint8_t* data, size_t size)
+{
+  uint64_t result = 0xcbf29ce484222325ull;
+  for ( size_t i = 0; i < size; ++i ) {
+    result ^= data[i];
+    result *= 0x100000001b3ull;
+  }
+  return result;
+}
+
+
+
+std::string
+SbPixelCache::cache_file(const std::string& filename)
+{
+  std::string name;
+  for ( char c: filename ) {
+    if ( c == '%' )
+      name += "%25";
+    else if ( c == '/' )
+      name += "%2F";
+    else if ( c == '\\' )
+      name += "%5C";
+    else
+      name += c;
+  }
+  return directory_ + "/" + name + ".pix";
+}
+
+
+
+SDL_Texture*
+SbPixelCache::load_texture(SDL_Renderer* renderer, const std::string& filename)
+{
+  if ( directory_.empty() )
+    return SbRenderStats::load_texture( renderer, filename );
+
+  // an image in the mounted pack is as old as the pack
+  size_t size = 0;
+  const uint8_t* data = SbResourcePack::mounted() ? SbResourcePack::mounted()->find( filename, size ) : nullptr;
+  struct stat info;
+  if ( stat( data ? SbResourcePack::mounted()->filename().c_str() : filename.c_str(), &info ) != 0 )
+    return SbRenderStats::load_texture( renderer, filename );
+
+  Header source = Header();
+  source.source_size = data ? size : info.st_size;
+  source.source_time = int64_t( info.st_mtim.tv_sec ) * 1000000000 + info.st_mtim.tv_nsec;
+  source.format = SDL_PIXELFORMAT_ARGB8888;
+  SDL_RendererInfo renderer_info;
+  if ( SDL_GetRendererInfo( renderer, &renderer_info ) == 0 && renderer_info.num_texture_formats > 0 && SDL_BYTESPERPIXEL( renderer_info.texture_formats[0] ) == 4 )
+    source.format = renderer_info.texture_formats[0];
+
+  // size and time first, the image is only read if they changed
+  SDL_Texture* texture = from_cache( renderer, filename, source );
+  if ( texture ) {
+    ++hits_;
+    return texture;
+  }
+
+  std::vector<uint8_t> file_data;
+  if ( !data ) {
+    std::ifstream file( filename, std::ios::binary );
+    if ( !file )
+      return SbRenderStats::load_texture( renderer, filename );
+    file_data.assign( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+    data = file_data.data();
+    size = file_data.size();
+    source.source_size = size;
+  }
+  source.source_hash = hash( data, size );
+  texture = from_cache( renderer, filename, source );
+  if ( texture ) {
+    // the time did not match, the hash did: touched, not changed, e.g. by a checkout
+    set_time( filename, source );
+    ++hits_;
+    return texture;
+  }
+
+  ++misses_;
+  Uint32 format = source.format;
+  SDL_Surface* decoded = IMG_Load_RW( SDL_RWFromConstMem( data, size ), 1 );
+  if ( !decoded )
+    return nullptr;
+  SDL_Surface* converted = SDL_ConvertSurfaceFormat( decoded, format, 0 );
+  SDL_FreeSurface( decoded );
+  if ( !converted )
+    return nullptr;
+  texture = upload( renderer, format, converted->w, converted->h, converted->pixels, converted->pitch );
+  Header header = source;
+  std::memcpy( header.magic, magic, sizeof(magic) );
+  header.version = version;
+  header.width = converted->w;
+  header.height = converted->h;
+  header.pitch = converted->pitch;
+  try {
+    write( cache_file(filename), header, converted );
+  }
+  catch (const std::exception& expt) {
+    // the game runs without the cache, just slower to start
+    std::cerr << expt.what() << std::endl;
+  }
+  SDL_FreeSurface( converted );
+  return texture;
+}
+
+
+
+SDL_Texture*
+SbPixelCache::from_cache(SDL_Renderer* renderer, const std::string& filename, const Header& source)
+{
+  int fd = ::open( cache_file(filename).c_str(), O_RDONLY );
+  if ( fd < 0 )
+    return nullptr;
+  struct stat info;
+  if ( fstat( fd, &info ) != 0 || info.st_size < off_t(pixel_offset) ) {
+    close(fd);
+    return nullptr;
+  }
+  size_t size = info.st_size;
+  void* mapped = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close(fd);
+  if ( mapped == MAP_FAILED )
+    return nullptr;
+
+  SDL_Texture* texture = nullptr;
+  const Header* header = static_cast<const Header*>(mapped);
+  // source_hash 0: not hashed yet
+  bool by_time = header->source_time == source.source_time;
+  bool by_hash = source.source_hash != 0 && header->source_hash == source.source_hash;
+  if ( std::memcmp( header->magic, magic, sizeof(magic) ) == 0 && header->version == version
+       && ( by_time || by_hash ) && header->source_size == source.source_size && header->format == source.format
+       && header->width > 0 && header->height > 0 && header->pitch >= header->width * 4
+       && ( size - pixel_offset ) / header->pitch >= uint64_t(header->height) ) {
+    texture = upload( renderer, source.format, header->width, header->height, static_cast<const uint8_t*>(mapped) + pixel_offset, header->pitch );
+  }
+  munmap( mapped, size );
+  return texture;
+}
+
+
+
+SDL_Texture*
+SbPixelCache::upload(SDL_Renderer* renderer, Uint32 format, int width, int height, const void* pixels, int pitch)
+{
+  auto lock = SbRenderStats::lock_renderer();
+  SDL_Texture* texture = SbRenderStats::create_texture( renderer, format, SDL_TEXTUREACCESS_STATIC, width, height );
+  if ( !texture )
+    return nullptr;
+  if ( SDL_UpdateTexture( texture, nullptr, pixels, pitch ) != 0 ) {
+    SbRenderStats::destroy_texture( texture );
+    return nullptr;
+  }
+  // as SDL_CreateTextureFromSurface does for images with alpha
+  SDL_SetTextureBlendMode( texture, SDL_BLENDMODE_BLEND );
+  return texture;
+}
+
+
+
+void
+SbPixelCache::set_time(const std::string& filename, const Header& source)
+{
+  // only the time changes, in place is good enough
+  std::fstream file( cache_file(filename), std::ios::binary | std::ios::in | std::ios::out );
+  file.seekp( offsetof(Header, source_time) );
+  file.write( reinterpret_cast<const char*>(&source.source_time), sizeof(source.source_time) );
+}
+
+
+
+void
+SbPixelCache::write(const std::string& filename, const Header& header, const SDL_Surface* surface)
+{
+  if ( mkdir( directory_.c_str(), 0755 ) != 0 && errno != EEXIST )
+    throw std::runtime_error("[SbPixelCache::write] Error: Couldn't create " + directory_ + ": " + std::strerror(errno) );
+  // written next to the target and renamed over it, so that a game starting meanwhile never maps half a file
+  std::string temporary = filename + ".tmp";
+  std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+  if ( !file )
+    throw std::runtime_error("[SbPixelCache::write] Error: Couldn't open file " + temporary );
+  char padding[pixel_offset] = {};
+  file.write( reinterpret_cast<const char*>(&header), sizeof(header) );
+  file.write( padding, pixel_offset - sizeof(header) );
+  file.write( static_cast<const char*>(surface->pixels), size_t(surface->pitch) * surface->h );
+  file.close();
+  if ( !file || std::rename( temporary.c_str(), filename.c_str() ) != 0 ) {
+    std::remove( temporary.c_str() );
+    throw std::runtime_error("[SbPixelCache::write] Error: Couldn't write " + filename );
+  }
+}
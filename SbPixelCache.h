@@ -0,0 +1,69 @@
+/*! \file SbPixelCache.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBPIXELCACHE_H
+#define SBPIXELCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#include <SDL2/SDL.h>
+
+
+/*! Keeps decoded images on disk in the pixel format of the renderer, so that later starts upload them without decoding.
+  The first load_texture() of an image decodes it with SDL_image, converts it to the renderer's first texture format and writes the pixels to directory()/<path>.pix (see cache_file()) together with the size, modification time and a hash of the image file, or of the SbResourcePack it came from. Later loads map the .pix file and, if size, time and format still match, upload the pixels straight from the mapping without reading the image. Only when the time changed is the image hashed: if the hash still matches, e.g. after a fresh checkout, the entry is kept and gets the new time, else it is replaced.
+  An empty directory turns the cache off.
+ */
+class SbPixelCache
+{
+ public:
+  static const uint32_t version = 2;
+  //! pixels start at this offset in a cache file
+  static const uint32_t pixel_offset = 64;
+
+  static SDL_Texture* load_texture(SDL_Renderer* renderer, const std::string& filename);
+
+  static void set_directory(const std::string& directory) { directory_ = directory; }
+  static const std::string& directory() { return directory_; }
+  /*! The cache file of filename, named after its path with %, / and backslash percent-encoded, so that different paths never share an entry.
+   */
+  static std::string cache_file(const std::string& filename);
+  //! 64 bit FNV-1a
+  static uint64_t hash(const uint8_t* data, size_t size);
+  //! loads served from the cache and not, over all threads
+  static uint64_t hits() { return hits_; }
+  static uint64_t misses() { return misses_; }
+
+ private:
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+    //! ns since the epoch
+    int64_t source_time;
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+  };
+
+  /*! The texture from the cache file of filename if its size and format match source and either its time or, if source has one, its hash.
+   */
+  static SDL_Texture* from_cache(SDL_Renderer* renderer, const std::string& filename, const Header& source);
+  //! write the time of source into the cache file of filename
+  static void set_time(const std::string& filename, const Header& source);
+  static SDL_Texture* upload(SDL_Renderer* renderer, Uint32 format, int width, int height, const void* pixels, int pitch);
+  static void write(const std::string& filename, const Header& header, const SDL_Surface* surface);
+
+  static std::string directory_;
+  static std::atomic<uint64_t> hits_;
+  static std::atomic<uint64_t> misses_;
+};
+
+
+#endif  // SBPIXELCACHE_H
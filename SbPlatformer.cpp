@@ -10,6 +10,9 @@
 #include "SbTexture.h"
 #include "SbTimer.h"
 #include "SbFont.h"
+#include "SbRenderStats.h"
+#include "SbOptions.h"
+#include "SbBatchRunner.h"
 
 #include "SbPlatformer.h"
 
@@ -23,7 +26,7 @@ Player::Player(const SbDimension* ref)
   velocity_x_ = 0;
   velocity_ = 1.0/5000.0;
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle(window->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
+  texture_->from_rectangle(window()->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
   name_ = "player";
 }
 
@@ -58,87 +61,38 @@ Player::check_exit(const Exit& exit)
 
 
 void
-Player::handle_event(const SDL_Event& event)
+Player::control(const SbInputState& input)
 {
-  double sensitivity = 1.0 ; // controller needs slower acceleration
-  //  SbControlDir direction = SbControlDir::none;
-
-  //  if( event.type == SDL_KEYDOWN && event.key.repeat == 0  ) {
-  if( event.type == SDL_KEYDOWN  && event.key.repeat == 0) {
-    switch( event.key.keysym.sym  ) {
-    case SDLK_UP: case SDLK_SPACE: direction_ = SbControlDir::up; break;
-    case SDLK_DOWN: direction_ = SbControlDir::down; break;
-    case SDLK_LEFT: direction_ = SbControlDir::left; break;
-    case SDLK_RIGHT: direction_ = SbControlDir::right; break;
-    }
-  }
-  if( event.type == SDL_KEYUP  && event.key.repeat == 0) {
-    switch( event.key.keysym.sym  ) {
-    case SDLK_UP: case SDLK_DOWN: case SDLK_SPACE: direction_ = SbControlDir::none; break;
-    case SDLK_LEFT: case SDLK_RIGHT: direction_ = SbControlDir::none; break;
-    }
-  }
-  else if( event.type == SDL_CONTROLLERAXISMOTION &&  event.jaxis.which == 0 ) {
-      sensitivity = controller_sensitivity_;
-      direction_ = SbControlDir::none; 
-    switch ( event.jaxis.axis ) {
-    case 0: //X axis motion
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::left;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::right;
-      break;
-    case 1:
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::up;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::down;
-      break;
-    }
+  // the stick moves and jumps with less force than keys and buttons
+  bool jump = input.is_held(SbAction::jump) || input.is_held(SbAction::up);
+  if ( jump && on_surface_ ) {
+    bool analog = !input.is_held(SbAction::jump) && input.is_analog(SbAction::up);
+    velocity_y_ = -1 * ( velocity_jump_ * ( analog ? controller_sensitivity_ : 1.0 ) );
+    on_surface_ = false;
+    standing_on_ = -1;
+    in_air_deltav_ = 0;
   }
-  else if( event.type == SDL_JOYAXISMOTION &&  event.jaxis.which == 0 ) {
-    direction_ = SbControlDir::none; 
-    switch ( event.jaxis.axis ) {
-    case 0: //X axis motion
-      sensitivity = controller_sensitivity_;
-      if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::left;
-      else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-	direction_ = SbControlDir::right;
-      break;
-    // case 1:
-    //   sensitivity = 0.1;
-    //   if ( event.jaxis.value < -CONTROLLER_DEADZONE )
-    // 	direction_ = SbControlDir::up;
-    //   else if ( event.jaxis.value > CONTROLLER_DEADZONE )
-    // 	direction_ = SbControlDir::down;
-    //   break;
-    }
+
+  SbControlDir direction = SbControlDir::none;
+  double sensitivity = 1.0;
+  if ( input.is_held(SbAction::left) ) {
+    direction = SbControlDir::left;
+    if ( input.is_analog(SbAction::left) ) sensitivity = controller_sensitivity_;
   }
-  else if (   event.type == SDL_CONTROLLERBUTTONDOWN
-	      && event.cbutton.which == 0
-	      && event.cbutton.button == SDL_CONTROLLER_BUTTON_A ) {
-	direction_ = SbControlDir::up;   
+  else if ( input.is_held(SbAction::right) ) {
+    direction = SbControlDir::right;
+    if ( input.is_analog(SbAction::right) ) sensitivity = controller_sensitivity_;
   }
-
-  switch (direction_) {
-  case SbControlDir::up :
-    if (on_surface_) {
-      velocity_y_ = -1 * ( velocity_jump_ * sensitivity );
-      on_surface_ = false;
-      standing_on_ = nullptr;
-      in_air_deltav_ = 0;
-    }
-    break;
-  case SbControlDir::left :
-    if (check_air_deltav(sensitivity) ) {
-      velocity_x_ =  -( velocity_ * sensitivity );
-      movement_start_position = pos_x();
-    }
-    break;
-  case SbControlDir::right :
-    if (check_air_deltav(sensitivity) ) {
-      velocity_x_ = ( velocity_ * sensitivity );
+  else if ( jump )
+    direction = SbControlDir::up;
+  else if ( input.is_held(SbAction::down) )
+    direction = SbControlDir::down;
+
+  switch (direction) {
+  case SbControlDir::left : case SbControlDir::right :
+    // in mid-air only a change of direction counts against allowed_air_deltav_
+    if ( ( on_surface_ || direction != direction_ ) && check_air_deltav(sensitivity) ) {
+      velocity_x_ = ( direction == SbControlDir::left ? -1 : 1 ) * ( velocity_ * sensitivity );
       movement_start_position = pos_x();
     }
     break;
@@ -148,21 +102,22 @@ Player::handle_event(const SDL_Event& event)
   default:
     break;
   }
+  direction_ = direction;
 }
 
 
 
 void
-Player::follow_platform()
+Player::follow_platform(const SbComponentStore& level)
 {
-  if (standing_on_) {
-    bounding_rect_.y = (*standing_on_)->pos_y() - bounding_rect_.h;
+  if ( standing_on_ >= 0 && size_t(standing_on_) < level.size() ) {
+    bounding_rect_.y = level.rect(standing_on_).y - bounding_rect_.h;
   }
 }
 
 
 int
-Player::move(const std::vector<std::unique_ptr<SbObject>>& level)
+Player::move(const SbComponentStore& level)
 {
   int result = 0;
   if ( exit_ ) {
@@ -198,8 +153,14 @@ Player::move(const std::vector<std::unique_ptr<SbObject>>& level)
 
   //  int hits = 0 ;   // can only hit max 2 tiles at once
   on_surface_ = false;
-  for (auto& tile: level){
-    SbHitPosition hit = check_hit(*tile);
+  const std::vector<SDL_Rect>& platforms = level.rects();
+  for ( size_t i = 0; i < platforms.size(); ++i ) {
+    const SDL_Rect& tile = platforms[i];
+    // check_hit() only reports platforms touching the player, most are nowhere near
+    if ( tile.x > bounding_rect_.x + bounding_rect_.w || tile.x + tile.w < bounding_rect_.x
+	 || tile.y > bounding_rect_.y + bounding_rect_.h || tile.y + tile.h < bounding_rect_.y )
+      continue;
+    SbHitPosition hit = check_hit(tile);
     if ( hit == SbHitPosition::none )
       continue;
     else {
@@ -208,19 +169,19 @@ Player::move(const std::vector<std::unique_ptr<SbObject>>& level)
       case SbHitPosition::left :
 	if (velocity_x_ > 0 )
 	  velocity_x_ = 0;
-	bounding_rect_.x = tile->pos_x() - bounding_rect_.w;
+	bounding_rect_.x = tile.x - bounding_rect_.w;
 	break;
       case SbHitPosition::right :
 	if (velocity_x_ < 0 )
 	  velocity_x_ = 0;  
-	bounding_rect_.x = tile->pos_x() + tile->width();
+	bounding_rect_.x = tile.x + tile.w;
 	break;
       case SbHitPosition::top :
-	velocity_y_ = tile->velocity_y(); // 
-	//	velocity_x_ += tile->velocity_x(); // 
-	bounding_rect_.y = tile->pos_y() - bounding_rect_.h;
+	velocity_y_ = level.velocity(i).y; // 
+	//	velocity_x_ += level.velocity(i).x; // 
+	bounding_rect_.y = tile.y - bounding_rect_.h;
 	on_surface_ = true;
-	standing_on_ = &tile;
+	standing_on_ = i;
 	//in_air_deltav_ = 0;
 	break;
       case SbHitPosition::bottom :
@@ -247,6 +208,7 @@ void
 Player::reset()
 {
   exit_ = false;
+  standing_on_ = -1;
   velocity_x_ = 0;
   velocity_y_ = 0;
   bounding_rect_.x = (int)(0.9*LEVEL_WIDTH);
@@ -257,86 +219,28 @@ Player::reset()
 
 
 
-/*! Platform implementation
- */
-Platform::Platform(int x, int y, int width, int height, const SbDimension* ref)
-  : SbObject(SDL_Rect{x, y, width, height}, ref)
-{
-  color_ = {40, 40, 160, 0};
-  texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
-  name_ = "tile";
-}
-
-
-
-Platform::Platform( SbRectangle bounding_box, const SbDimension* ref )
-  : SbObject( bounding_box, ref)
-{
-  SDL_Color color = {40, 40, 160, 0};
-  texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle( window->renderer(), bounding_rect_.w, bounding_rect_.h, color );
-  name_ = "tile";
-}
-
-
-
-int
-Platform::move()
-{
-  Uint32 deltaT = timer_.get_time();
-  
-  if (velocity_.x > 0 && limits_.left != limits_.right ) {
-    if ( bounding_rect_.x + bounding_rect_.w >= limits_.right ) {
-      if ( velocity_x_ > 0 ) velocity_x_ *= -1;
-    }
-    else if( bounding_rect_.x < limits_.left ) {
-      if (velocity_x_ < 0 ) velocity_x_ *= -1;
-    }
-  }
-  if (velocity_.y > 0 && limits_.top != limits_.bottom ) {
-    if ( bounding_rect_.y + bounding_rect_.h >= limits_.bottom ) {
-      if ( velocity_y_ > 0 ) velocity_y_ *= -1;
-    }
-    else if ( bounding_rect_.y < limits_.top ) {
-      if ( velocity_y_ < 0 ) velocity_y_ *= -1;
-    }
-  }
-
-  bounding_box_.y += velocity_y_ * deltaT;
-  bounding_box_.x += velocity_x_ * deltaT;
-
-  move_bounding_rect();
-  timer_.start();
-  return 0;
-}
-
-
 void
-Platform::set_velocities(double x, double y)
+Player::save_state(SbSnapshot& snapshot) const
 {
-  velocity_= {x, y};
-  velocity_x_ = x;
-  velocity_y_ = y;
+  SbObject::save_state( snapshot );
+  snapshot.write( exit_ );
+  snapshot.write( on_surface_ );
+  snapshot.write( in_air_deltav_ );
+  snapshot.write( movement_start_position );
+  snapshot.write( direction_ );
 }
 
 
-void
-Platform::set_velocities(Velocity v)
-{
-  velocity_= v;
-  velocity_x_ = v.x;
-  velocity_y_ = v.y;
-}
-
 
 void
-Platform::set_limits(MovementLimits limit)
+Player::restore_state(SbSnapshot& snapshot)
 {
-  limits_.left = bounding_rect_.x - limit.left;
-  limits_.right = bounding_rect_.x + bounding_rect_.w + limit.right;
-  limits_.top = bounding_rect_.y - limit.top;
-  limits_.bottom = bounding_rect_.y + bounding_rect_.h + limit.bottom;
+  SbObject::restore_state( snapshot );
+  snapshot.read( exit_ );
+  snapshot.read( on_surface_ );
+  snapshot.read( in_air_deltav_ );
+  snapshot.read( movement_start_position );
+  snapshot.read( direction_ );
 }
 
 
@@ -348,7 +252,7 @@ Platform::set_limits(MovementLimits limit)
 // {
 //   color_ = {200, 100, 100};
 //   texture_ = std::make_shared<SbTexture>();
-//   texture_->from_rectangle(window->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
+//   texture_->from_rectangle(window()->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
 //   name_ = "goal";
 // }
 
@@ -358,7 +262,7 @@ Exit::Exit(SbRectangle box, const SbDimension* ref)
 {
    color_ = {200, 100, 100};
   texture_ = std::make_shared<SbTexture>();
-  texture_->from_rectangle(window->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
+  texture_->from_rectangle(window()->renderer(), bounding_rect_.w, bounding_rect_.h, color_ );
   name_ = "goal";
 }
 
@@ -366,8 +270,10 @@ Exit::Exit(SbRectangle box, const SbDimension* ref)
 
 /*! Level implementation
  */
-Level::Level(uint32_t num, const SbDimension* window_ref)
-  : level_num_(num)
+Level::Level(const SbLevelFile& levels, uint32_t num, const SbDimension* window_ref)
+  : levels_(levels)
+  , level_num_(num)
+  , platforms_(&dimension_)
 {
   create_level(level_num_);
 }
@@ -376,51 +282,64 @@ Level::Level(uint32_t num, const SbDimension* window_ref)
 void
 Level::create_level(uint32_t num)
 {
-  if ( !platforms_.empty() )
-    platforms_.clear();
+  // the platforms, the exit and their textures all go at once
+  platforms_.clear();
+  textures_.clear();
+  exit_ = nullptr;
+  arena_.reset();
+  timer_.reset();
   
-  if (num > levels.size() )
-    throw std::runtime_error("[Level::create_level] No level found for level number = " + std::to_string(num)  );
-
-  dimension_ = levels.at(num).dimension;
-  std::vector< SbRectangle > &coords = (levels.at(num).tiles);
-  SbRectangle& goal = levels.at(num).goal;
-  std::vector<MovementRange>& ranges = (levels.at(num).ranges);
-  std::vector<Velocity>& vels = (levels.at(num).velocities);
-  for ( uint32_t i = 0; i < coords.size(); ++i ){
-    // int x = coords.at(i).x * width_;
-    // int y = coords.at(i).y * height_;
-    // int w = coords.at(i).w * width_;
-    // int h = coords.at(i).h * height_;
-    
-    Platform* p = new Platform( coords.at(i), get_dimension() );
-    if (ranges.size() > i && vels.size() > i){
-      MovementRange& rg = ranges.at(i);
-      MovementLimits lmt = rg.to_limits(dimension_.w, dimension_.h);
-      p->set_limits(lmt);
-      p->set_velocities(vels.at(i));
+  SbLevelView level = levels_.level(num);
+  level_num_ = num;
+  dimension_ = level.dimension;
+  // static platforms are merged into as few as possible, moving ones are kept as they are
+  std::vector<SbRectangle> fixed;
+  for ( uint32_t i = 0; i < level.n_tiles; ++i ){
+    if ( level.ranges && ( level.velocities[i].x != 0 || level.velocities[i].y != 0 ) ) {
+      const SbRectangle& box = level.tiles[i];
+      SbComponentStore::Entity p = platforms_.create( box, platform_texture( static_cast<int>(box.w * dimension_.w), static_cast<int>(box.h * dimension_.h) ) );
+      MovementLimits lmt = level.ranges[i].to_limits(dimension_.w, dimension_.h);
+      platforms_.add_motion( p, level.velocities[i], lmt );
     }
-    
-    platforms_.emplace_back( std::unique_ptr<SbObject>( p ) );
+    else
+      fixed.push_back( level.tiles[i] );
+  }
+  for ( const SbRectangle& box: SbTileOptimizer::optimize( fixed.data(), fixed.size(), dimension_ ) )
+    platforms_.create( box, platform_texture( static_cast<int>(box.w * dimension_.w), static_cast<int>(box.h * dimension_.h) ) );
+  platforms_in_file_ = level.n_tiles;
+  exit_ = arena_.create<Exit>( level.goal, get_dimension() );
+}
+
+
+
+std::shared_ptr<SbTexture>
+Level::platform_texture(int width, int height)
+{
+  std::shared_ptr<SbTexture>& texture = textures_[ std::make_pair( width, height ) ];
+  if ( !texture ) {
+    SDL_Color color = {40, 40, 160, 0};
+    texture = std::allocate_shared<SbTexture>( SbArena::Allocator<SbTexture>(&arena_) );
+    texture->from_rectangle( SbObject::window()->renderer(), width, height, color );
   }
-  exit_ = std::unique_ptr<Exit>( new Exit{ goal, get_dimension() } );
-  //  exit_ = std::unique_ptr<Exit>( new Exit{ (int)(goal.x*LEVEL_WIDTH), (int)(goal.y*LEVEL_HEIGHT), (int)(goal.w*LEVEL_WIDTH), (int)(goal.h*LEVEL_HEIGHT) } );
+  return texture;
 }
 
 
 void
-Level::move()
+Level::move(SbJobSystem* jobs)
 {
-  for (auto& p: platforms_)
-    p->move();
+  if ( jobs )
+    SbSystems::move( platforms_, timer_.get_time(), *jobs );
+  else
+    SbSystems::move( platforms_, timer_.get_time() );
+  timer_.start();
 }
 
 
 void
 Level::render(const SDL_Rect &camera)
 {
-    for (auto& t: platforms_)
-      t->render(camera);
+    SbSystems::render( platforms_, SbObject::window()->renderer(), camera );
     exit_->render( camera );
 }
 
@@ -434,9 +353,37 @@ Level::update_size()
 
 
 
-Platformer::Platformer()
+void
+Level::save_state(SbSnapshot& snapshot) const
 {
-  SbObject::window = &window_ ;
+  snapshot.write( level_num_ );
+  snapshot.write( timer_.get_time() );
+  snapshot.write( timer_.started() );
+  platforms_.save_state( snapshot );
+}
+
+
+
+void
+Level::restore_state(SbSnapshot& snapshot)
+{
+  snapshot.read( level_num_ );
+  Uint32 time = 0;
+  bool started = false;
+  snapshot.read( time );
+  snapshot.read( started );
+  timer_.set_time( time, started );
+  platforms_.restore_state( snapshot );
+}
+
+
+
+Platformer::Platformer(const std::string& level_file)
+{
+  SbGameContext::make_current( &context_ );
+  context_.window = &window_;
+  input_.deadzone = CONTROLLER_DEADZONE;
+  set_worker_threads( SbJobSystem::default_workers() );
 
   for (int i = 0; i < SDL_NumJoysticks(); ++i) {
     if (SDL_IsGameController(i)) {
@@ -447,19 +394,28 @@ Platformer::Platformer()
     }
   }
 
-levels.emplace_back(dim0, lev0, goal0, range0, velocity0);
-
+  levels_ = std::unique_ptr<SbLevelFile>( new SbLevelFile(level_file) );
   initialize();
 }
 
 
 Platformer::~Platformer()
 {
+  // the members go after this, with their textures counted in this game
+  SbGameContext::make_current( &context_ );
   SDL_GameControllerClose( game_controller_ );
   game_controller_ = nullptr;
 }
 
 
+
+void
+Platformer::set_worker_threads(unsigned n)
+{
+  jobs_ = std::unique_ptr<SbJobSystem>( new SbJobSystem(n) );
+}
+
+
 void
 Platformer::initialize()
 {
@@ -470,9 +426,13 @@ Platformer::initialize()
   // if ( !font )
   //   throw std::runtime_error( "TTF_OpenFont: " + std::string( TTF_GetError() ) );
 
-  level_ = std::unique_ptr<Level>( new Level(current_level_, window_.get_dimension()) );
+  level_ = std::unique_ptr<Level>( new Level(*levels_, current_level_, window_.get_dimension()) );
   player_ = std::unique_ptr<Player>( new Player(level_->get_dimension()) );
+#ifdef DEBUG
+  std::cout << "[Platformer] level " << level_->level_number() << ": " << level_->platforms_in_file() << " platforms merged into " << level_->platforms().size() << std::endl;
+#endif // DEBUG
   fps_display_ = std::unique_ptr<SbFpsDisplay>( new SbFpsDisplay( font.font(), SbRectangle{0, 0, 0.06, 0.035}, window_.get_dimension() ) );
+  render_stats_ = std::unique_ptr<SbRenderStatsDisplay>( new SbRenderStatsDisplay( font.font(), SbRectangle{0, 0.035, 0.3, 0.035}, window_.get_dimension() ) );
   
 }
 
@@ -481,89 +441,199 @@ Platformer::initialize()
 void
 Platformer::reset()
 {
-  if ( (++current_level_) == levels.size() ) {
+  if ( (++current_level_) >= levels_->size() ) {
     current_level_ = 0;
   }
   level_->create_level( current_level_ );
+#ifdef DEBUG
+  std::cout << "[Platformer] level " << level_->level_number() << ": " << level_->platforms_in_file() << " platforms merged into " << level_->platforms().size() << std::endl;
+#endif // DEBUG
   player_->reset();
-  reset_timer_.reset();
+  // when called before the delay is up
+  timers_.cancel( level_change_ );
   in_exit_ = false;
+  rewind_.clear();
 }
 
 
-Uint32
-Platformer::reset_game(Uint32 interval, void *param )
+void
+Platformer::snapshot(SbSnapshot& snapshot) const
 {
-  ((Platformer*)param)->reset();
-  return(0);
+  snapshot.clear();
+  snapshot.write( current_level_ );
+  snapshot.write( in_exit_ );
+  snapshot.write( timers_.remaining( level_change_ ) );
+  level_->save_state( snapshot );
+  player_->save_state( snapshot );
+  snapshot.write( player_->standing_on() );
 }
 
 
 
+void
+Platformer::restore(SbSnapshot& snapshot)
+{
+  snapshot.rewind();
+  uint32_t level = 0;
+  snapshot.read( level );
+  if ( level != current_level_ )
+    throw std::runtime_error("[Platformer::restore] Error: snapshot of level " + std::to_string(level) + ", playing level " + std::to_string(current_level_) );
+  Uint32 remaining = 0;
+  snapshot.read( in_exit_ );
+  snapshot.read( remaining );
+  timers_.cancel( level_change_ );
+  if ( remaining > 0 )
+    level_change_ = timers_.schedule( remaining, [this]() { reset(); } );
+  level_->restore_state( snapshot );
+  player_->restore_state( snapshot );
+  int32_t standing_on = -1;
+  snapshot.read( standing_on );
+  player_->set_standing_on( standing_on );
+}
+
+
 void
 Platformer::run()
 {
-    SDL_Event event;
-    bool quit = false;
-
-    
-    while (!quit) {
-      /// begin event polling
-      while( SDL_PollEvent( &event ) ) {
-	if (event.type == SDL_QUIT) quit = true;
-	else if (event.type == SDL_KEYDOWN ) {
-	  switch ( event.key.keysym.sym ) {
-	  case SDLK_ESCAPE:
-	    quit = true;
-	    break;
-	  }
-	}
-	else if (   event.type == SDL_CONTROLLERBUTTONDOWN
-		    && event.cbutton.which == 0
-		    && event.cbutton.button == SDL_CONTROLLER_BUTTON_B ) {
-	  quit = true;
-	}
-	if (window_.handle_event(event)){
-	  fps_display_->update_size();
-	}
-	player_->handle_event(event);
-	//	level_->handle_event( event );
-      }
-      /// end event polling
+  while (!quit_)
+    frame();
+}
 
-      if ( reset_timer_.get_time() > 1500 )
-	reset();
-	
 
-      player_->move(level_->platforms());
-      level_->move();
-      player_->follow_platform();
-      player_->center_camera(camera_, LEVEL_WIDTH, LEVEL_HEIGHT);
-      if ( !in_exit_ ) {
-	in_exit_ = player_->check_exit(level_->exit());
-	if (in_exit_) {
-	  //	  SDL_AddTimer(2000, Maze::reset_game, this);
-	  reset_timer_.start();
-	}
+
+void
+Platformer::frame()
+{
+  SDL_Event event;
+
+  SbGameContext::make_current( &context_ );
+  watchdog_.begin_frame();
+  events_.begin_frame();
+  /// begin event polling
+  while( events_.poll( event ) ) {
+    if (event.type == SDL_QUIT) quit_ = true;
+    if (window_.handle_event(event)){
+      fps_display_->update_size();
+      render_stats_->update_size();
+    }
+    input_.handle_event(event);
+    render_stats_->handle_event(event);
+    //	level_->handle_event( event );
+  }
+  /// end event polling
+  const SbInputState& input = input_.sample();
+  if ( input.was_pressed(SbAction::quit) )
+    quit_ = true;
+  watchdog_.phase("events");
+
+  timers_.update();
+	
+  if ( !in_exit_ && input.is_held(SbAction::rewind) ) {
+    // one frame back per frame
+    if ( rewind_.step_back( snapshot_ ) )
+      restore( snapshot_ );
+  }
+  else {
+    player_->control( input );
+    player_->move(level_->platforms());
+    level_->move( jobs_.get() );
+    player_->follow_platform(level_->platforms());
+    if ( !in_exit_ ) {
+      in_exit_ = player_->check_exit(level_->exit());
+      if (in_exit_) {
+	level_change_ = timers_.schedule( LEVEL_CHANGE_DELAY, [this]() { reset(); } );
+      }
+      else {
+	snapshot( snapshot_ );
+	rewind_.push( snapshot_ );
       }
-      fps_display_->update();
+    }
+  }
+  player_->center_camera(camera_, LEVEL_WIDTH, LEVEL_HEIGHT);
+  fps_display_->update();
+  render_stats_->update();
+  watchdog_.phase("update");
       
-      SDL_RenderClear( window_.renderer() );
-      level_->render( camera_ );
-      fps_display_->render();
-      player_->render( camera_ );
-      SDL_RenderPresent( window_.renderer() );
+  SbRenderStats::clear( window_.renderer() );
+  level_->render( camera_ );
+  fps_display_->render();
+  render_stats_->render();
+  player_->render( camera_ );
+  watchdog_.phase("render");
+  SbRenderStats::present( window_.renderer() );
+  watchdog_.phase("present");
+  watchdog_.end_frame();
+}
 
-    }
+
+#ifndef SB_NO_MAIN
+namespace {
+  //! frames of a scripted batch session unless --ticks says otherwise
+  const uint64_t script_ticks = 3600;
+
+  /*! Input of a scripted batch session: run right and left in turns of 5 s, jumping every second.
+   */
+  bool scripted_run(uint64_t frame, Uint8* keys, std::vector<SDL_Event>& events)
+  {
+    bool right = ( frame / 300 ) % 2 == 0;
+    keys[SDL_SCANCODE_RIGHT] = right;
+    keys[SDL_SCANCODE_LEFT] = !right;
+    keys[SDL_SCANCODE_SPACE] = ( frame % 60 ) < 3;
+    return true;
+  }
 }
 
 
-int main()
+int main(int argc, char* argv[])
 {
-  sdl_init();
+  SbOptions options;
+  std::string level_file = "resources/platformer.lvl";
+  int threads = -1;
+  try {
+    for ( int i = 1; i < argc; ++i ) {
+      std::string arg = argv[i];
+      if ( options.parse(i, argc, argv) )
+	continue;
+      else if ( arg == "--levels" && i + 1 < argc )
+	level_file = argv[++i];
+      else if ( arg == "--threads" && i + 1 < argc )
+	threads = std::stoi( argv[++i] );
+      else
+	throw std::runtime_error( "usage: " + std::string(argv[0]) + " [--levels file.lvl] [--threads n] " + SbOptions::usage() );
+    }
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    return 1;
+  }
+  
+  sdl_init(options.headless || options.batch > 0);
   try {
-    Platformer plat;
-    plat.run();
+    if ( options.batch > 0 ) {
+      // the threads go to the sessions, each session moves its platforms on its own
+      SbBatchRunner runner( threads >= 0 ? threads : SbJobSystem::default_workers() );
+      for ( unsigned i = 0; i < options.batch; ++i ) {
+	runner.add( [&]() {
+	    std::shared_ptr<Platformer> plat( new Platformer(level_file) );
+	    plat->set_worker_threads( 0 );
+	    if ( options.replay.empty() )
+	      plat->events()->script( scripted_run );
+	    options.apply( *plat->events(), *plat->watchdog(), *plat->window() );
+	    return SbBatchRunner::Tick( [plat]() { plat->frame(); return !plat->done(); } );
+	  } );
+      }
+      runner.run( ( options.ticks == 0 && options.replay.empty() ) ? script_ticks : options.ticks );
+      runner.print_statistics(std::cout);
+    }
+    else {
+      Platformer plat(level_file);
+      if ( threads >= 0 )
+	plat.set_worker_threads( threads );
+      options.apply( *plat.events(), *plat.watchdog(), *plat.window() );
+      plat.run();
+      if ( plat.events()->replaying() )
+	plat.events()->print_statistics(std::cout);
+    }
   }
   catch (const std::exception& expt) {
     std::cerr << expt.what() << std::endl;
@@ -571,5 +641,4 @@ int main()
   sdl_quit();
   return 0;
 }
-  
-
+#endif  // SB_NO_MAIN
@@ -2,6 +2,7 @@
 #define SBPLATFORMER_H
 
 #include <memory>
+#include <map>
 #include <vector>
 #include <string>
 
@@ -9,15 +10,28 @@
 #include <SDL2/SDL_ttf.h>
 
 #include "SbMessage.h"
+#include "SbEventSource.h"
+#include "SbFrameWatchdog.h"
 #include "SbWindow.h"
+#include "SbGameContext.h"
 #include "SbObject.h"
 #include "SbFont.h"
+#include "SbLevelFile.h"
+#include "SbTileOptimizer.h"
+#include "SbSnapshot.h"
+#include "SbArena.h"
+#include "SbComponents.h"
+#include "SbInput.h"
+#include "SbTimerWheel.h"
+#include "SbJobSystem.h"
 
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 const int LEVEL_WIDTH = 2000;
 const int LEVEL_HEIGHT = 1500;
 const int CONTROLLER_DEADZONE = 7000;
+//! ms between reaching the exit and the next level
+const Uint32 LEVEL_CHANGE_DELAY = 1500;
 const std::string name = "Platformer";
 const double GRAVITY = 2.5e-6;
 const double JUMP = 1.0/700.0;
@@ -26,81 +40,36 @@ const double PLAYER_VELOCITY = 1.0/2000.0;
 const double STEP_SIZE = LEVEL_WIDTH / 20;
   
 class Exit;
-class Platform;
 class Level;
 class Platformer;
 
 
-/* MovementLimits and MovementRange are used to define moving platforms
- */
-struct MovementLimits
-{
-  MovementLimits(uint32_t l, uint32_t r, uint32_t t, uint32_t b)
-  : left(l), right(r), top(t), bottom(b)
-  {}
-  MovementLimits() = default;
-
-  uint32_t left = 0;
-  uint32_t right = 0;
-  uint32_t top = 0;
-  uint32_t bottom = 0;
-};
-
-
-struct MovementRange
-{
-  MovementRange(double l, double r, double t, double b)
-  : left(l), right(r), top(t), bottom(b)
-  {}
-  MovementRange() = default;
-  
-  MovementLimits to_limits(uint32_t width, uint32_t height) {
-    MovementLimits result;
-    result.left = left * width;
-    result.right = right * width;
-    result.top = top * height;
-    result.bottom = bottom * height;
-    return result;
-  }
-
-  double left = 0;
-  double right = 0;
-  double top = 0;
-  double bottom = 0;
-};
-
-
-struct Velocity
-{
-  Velocity(double xdir, double ydir)
-  : x(xdir), y(ydir)
-  {}
-  Velocity() = default;
-  
-  double x = 0;
-  double y = 0;
-};
-
-
-
 class Player : public SbObject
 {
  public:
   Player(const SbDimension* ref);
 
   bool check_exit(const Exit& goal);
-  void handle_event(const SDL_Event& event);
-  int move(const std::vector<std::unique_ptr<SbObject>>& level);
-  void follow_platform();
+  /*! Jump, run or stop for this frame's input.
+   */
+  void control(const SbInputState& input);
+  int move(const SbComponentStore& level);
+  void follow_platform(const SbComponentStore& level);
   //  void render();
   /*! Reset after goal.
    */
   void reset();
+  void save_state(SbSnapshot& snapshot) const override;
+  void restore_state(SbSnapshot& snapshot) override;
+  /*! Entity of the platform the player stands on, -1 if none.
+   */
+  int32_t standing_on() const { return standing_on_; }
+  void set_standing_on(int32_t entity) { standing_on_ = entity; }
 
  private:
   bool check_air_deltav( double sensitivity );
 
-  const std::unique_ptr<SbObject>* standing_on_ = nullptr;
+  int32_t standing_on_ = -1;
   bool exit_ = false;
   double velocity_max_ = PLAYER_VELOCITY;
   double velocity_jump_ = JUMP;
@@ -112,29 +81,12 @@ class Player : public SbObject
   double controller_sensitivity_ = 0.1;
   double friction_ = FRICTION;
   double step_size = STEP_SIZE;
-  double movement_start_position;
+  double movement_start_position = 0;
   SbControlDir direction_ = SbControlDir::none;
 };
 
 
 
-class Platform : public SbObject
-{
-  friend class Level;
- public:
-  Platform(int x, int y, int width, int height, const SbDimension* ref);
-  Platform( SbRectangle bounding_box, const SbDimension* ref );
-    int move();
-    
- private:
-    Velocity velocity_;
-    MovementLimits limits_;
-    void set_velocities(double x, double y);
-    void set_velocities(Velocity v);
-    void set_limits(MovementLimits limit);
-};
-
-
 class Exit : public SbObject
 {
  public:
@@ -146,26 +98,44 @@ class Exit : public SbObject
 class Level
 {
  public:
-  Level(uint32_t num, const SbDimension* window_ref);
+  Level(const SbLevelFile& levels, uint32_t num, const SbDimension* window_ref);
 
   void create_level(uint32_t num);
    Exit const& exit() const {return *exit_;}
-  std::vector<std::unique_ptr<SbObject>> const& platforms() const {return platforms_; }
+  SbComponentStore const& platforms() const {return platforms_; }
+  //! platforms in the level file, platforms().size() is the number left after merging
+  uint32_t platforms_in_file() const { return platforms_in_file_; }
   uint32_t width() { return dimension_.w; }
   uint32_t height() {return dimension_.h; }
   void render(const SDL_Rect &camera);
   uint32_t level_number() { return level_num_; }
   //  void handle_event(const SDL_Event& event);
-  void move();
+  /*! Move the platforms, on jobs if given.
+   */
+  void move(SbJobSystem* jobs = nullptr);
   void update_size();
   const SbDimension* get_dimension() const {return &dimension_;} 
+  /*! Level number and the state of every moving platform.
+   */
+  void save_state(SbSnapshot& snapshot) const;
+  void restore_state(SbSnapshot& snapshot);
   
  private:
+  std::shared_ptr<SbTexture> platform_texture(int width, int height);
+
+  const SbLevelFile& levels_;
   SbDimension dimension_ = {100,100};
   const SbDimension* window_ref_;
   uint32_t level_num_ = 0;
-  std::unique_ptr<Exit> exit_ = nullptr;
-  std::vector<std::unique_ptr<SbObject>> platforms_;
+  //! owns the exit and the platform textures, create_level() resets it in one go
+  SbArena arena_;
+  Exit* exit_ = nullptr;
+  SbComponentStore platforms_;
+  //! time since the platforms last moved
+  SbTimer timer_;
+  //! one texture per platform size, shared by all platforms of that size
+  std::map<std::pair<int,int>, std::shared_ptr<SbTexture>> textures_;
+  uint32_t platforms_in_file_ = 0;
 };
 
 
@@ -173,70 +143,57 @@ class Level
 class Platformer
 {
  public:
-  Platformer();
+  Platformer(const std::string& level_file = "resources/platformer.lvl");
   ~Platformer();
   Platformer(const Platformer&)  = delete ;
   Platformer& operator=(const Platformer& toCopy) = delete;
 
   void initialize();
   void reset();
-  static Uint32 reset_game(Uint32 interval, void *param );
   void run();
+  /*! One pass of the game loop: poll events, move, render.
+   */
+  void frame();
+  //! quit was asked for, run() returns after this frame
+  bool done() const { return quit_; }
+  /*! Everything that changes while playing a level: level number, platforms, player, exit state. restore() throws if the snapshot is of another level.
+   */
+  void snapshot(SbSnapshot& snapshot) const;
+  void restore(SbSnapshot& snapshot);
+  SbEventSource* events() {return &events_; }
+  SbFrameWatchdog* watchdog() {return &watchdog_; }
   SbWindow* window() {return &window_; }
+  SbGameContext* context() {return &context_; }
+  /*! Threads besides the game loop for the update phase, 0 to run it all on the game loop.
+   */
+  void set_worker_threads(unsigned n);
   
  private:
+  //! first, so that it outlives everything that draws or times with it
+  SbGameContext context_;
   std::unique_ptr<Player> player_;
+  std::unique_ptr<SbLevelFile> levels_ = nullptr;
   std::unique_ptr<Level> level_ = nullptr;
   SDL_GameController* game_controller_ = nullptr;
   bool in_exit_ = false;
+  bool quit_ = false;
   uint32_t current_level_ = 0;
   SbWindow window_{name, SCREEN_WIDTH, SCREEN_HEIGHT};
   SDL_Rect camera_;
+  SbEventSource events_;
+  SbInput input_;
+  std::unique_ptr<SbJobSystem> jobs_;
+  SbFrameWatchdog watchdog_;
   std::unique_ptr<SbFpsDisplay> fps_display_ = nullptr;
-  SbTimer reset_timer_;
-
+  std::unique_ptr<SbRenderStatsDisplay> render_stats_ = nullptr;
+  //! delayed work, run on the game loop at the start of the update phase
+  SbTimerWheel timers_;
+  //! starts the next level after the goal delay
+  SbTimerWheel::Handle level_change_ = 0;
+  //! a snapshot every frame, for rewinding with backspace
+  SbRewindBuffer rewind_;
+  SbSnapshot snapshot_;
 };
 
 
-struct LevelCoordinates
-{
-LevelCoordinates(SbDimension d, std::vector<SbRectangle> t, SbRectangle g, std::vector<MovementRange> r, std::vector<Velocity> v)
-: dimension(d), tiles(t),goal(g), ranges(r), velocities(v)
-  {}
-  SbDimension dimension;
-  std::vector<SbRectangle> tiles;
-  SbRectangle goal;
-  std::vector<MovementRange> ranges;
-  std::vector<Velocity> velocities;
-};
-
-
-////////////////////
-////// levels //////
-////////////////////
-std::vector<LevelCoordinates> levels;
-
-SbDimension dim0 = {LEVEL_WIDTH, LEVEL_HEIGHT};
-std::vector<SbRectangle> lev0 = {{0,0,1.0,0.03}, {0.97,0.0,0.03,1.0}, {0.0,0.0,0.03,1.0}, {0.0, 0.97, 1.0, 0.03}  /* outer boxes */
-				 , {0.85, 0.75, 0.12, 0.03 }
-				 ,{0.03,0.77,0.12,0.03}, {0.18, 0.57, 0.12, 0.03}, {0.03, 0.37, 0.12, 0.03} 
-	};
-SbRectangle goal0 = {0.03, 0.25, 0.03, 0.12};
-std::vector<MovementRange> range0 = { {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0} /* outer frame */
-				      , {0, 0, 0.15, 0}
-				      , {0, 0.08, 0.0, 0.0}, {0.02, 0.1, 0.07, 0.05}, {0, 0, 0, 0}
-};
-std::vector<Velocity> velocity0 = { {0, 0}, {0, 0}, {0, 0}, {0, 0}
-				    ,{0, 0.00005}
-				    ,{ 0.00005, 0}, {0.00003, 0.00003}, {0,0}
-};
-
-
-////////////////////
-//// levels end ////
-////////////////////
-
-
-
-
 #endif  // SBPLATFORMER_H
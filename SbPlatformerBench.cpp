@@ -0,0 +1,87 @@
+/*! \file SbPlatformerBench.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+
+  Benchmarks of the Platformer: Player::move, Level::move with and without a rewind snapshot and on an SbJobSystem with a worker per core but one, Level::render and Level::create_level over synthetic levels of growing size and a full headless frame.
+  Links SbPlatformer.o built with -DSB_NO_MAIN.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+#include "SbWindow.h"
+#include "SbBench.h"
+#include "SbLevelFile.h"
+
+#include "SbPlatformer.h"
+
+
+/*! n_platforms platforms on a regular grid covering the level, every other one moving.
+ */
+static SbLevelData
+synthetic_level(uint32_t n_platforms)
+{
+  SbLevelData level;
+  level.dimension = SbDimension{LEVEL_WIDTH, LEVEL_HEIGHT};
+  level.goal = SbRectangle{0.03, 0.25, 0.03, 0.12};
+  uint32_t columns = std::ceil( std::sqrt(n_platforms) );
+  double step = 0.8 / columns;
+  for ( uint32_t i = 0; i < n_platforms; ++i ) {
+    level.tiles.emplace_back( 0.05 + (i % columns) * step, 0.05 + (i / columns) * step, step/2, step/8 );
+    level.ranges.emplace_back( 0, step/4, 0, 0 );
+    level.velocities.emplace_back( (i % 2) ? 0.00003 : 0, 0 );
+  }
+  return level;
+}
+
+
+
+int main(int argc, char* argv[])
+{
+  SbBench bench("platformer");
+  bench_init(bench, argc, argv);
+  try {
+    Platformer plat;
+    const SbDimension* window_ref = plat.window()->get_dimension();
+
+    const std::vector<uint32_t> sizes = {16, 64, 256, 1024, 4096, 16384};
+    std::vector<SbLevelData> data;
+    for ( uint32_t n_platforms: sizes )
+      data.push_back( synthetic_level(n_platforms) );
+    SbLevelFile::write( "bench_platformer.lvl", data );
+    SbLevelFile levels( "bench_platformer.lvl" );
+    SbJobSystem jobs;
+
+    for ( uint32_t num = 0; num < sizes.size(); ++num ) {
+      uint32_t n_platforms = sizes.at(num);
+      Level level(levels, num, window_ref);
+      Player player(level.get_dimension());
+      bench.run("player_move", n_platforms, [&]() { SbBench::keep( player.move(level.platforms()) ); } );
+      bench.run("level_move", n_platforms, [&]() { level.move(); } );
+      bench.run("level_move_jobs", n_platforms, [&]() { level.move(&jobs); } );
+      // as every frame: move, then a snapshot into the rewind buffer; compare with level_move
+      SbSnapshot snapshot;
+      SbRewindBuffer rewind;
+      bench.run("level_move_snapshot", n_platforms, [&]() { snapshot.clear(); level.move(); level.save_state(snapshot); rewind.push(snapshot); } );
+      SDL_Rect camera = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+      bench.run("level_render", n_platforms, [&]() { level.render(camera); } );
+      bench.run("level_create_level", n_platforms, [&]() { level.create_level(num); } );
+    }
+
+    bench.run("frame", 1, [&]() { plat.frame(); } );
+    // the same, submitting and presenting on the render thread
+    plat.window()->set_render_thread(true);
+    bench.run("frame_render_thread", 1, [&]() { plat.frame(); } );
+    plat.window()->set_render_thread(false);
+    std::remove( "bench_platformer.lvl" );
+  }
+  catch (const std::exception& expt) {
+    std::cerr << expt.what() << std::endl;
+    sdl_quit();
+    return 1;
+  }
+  sdl_quit();
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*! \file SbRenderStats.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include "SbResourcePack.h"
+#include "SbRenderThread.h"
+#include "SbGameContext.h"
+
+#include "SbRenderStats.h"
+
+
+SDL_Texture*
+SbRenderStats::create_texture( SDL_Renderer* renderer, Uint32 format, int access, int width, int height )
+{
+  auto lock = lock_renderer();
+  SDL_Texture* texture = SDL_CreateTexture( renderer, format, access, width, height );
+  texture_created( texture );
+  return texture;
+}
+
+
+SDL_Texture*
+SbRenderStats::create_texture( SDL_Renderer* renderer, SDL_Surface* surface )
+{
+  auto lock = lock_renderer();
+  SDL_Texture* texture = SDL_CreateTextureFromSurface( renderer, surface );
+  texture_created( texture );
+  return texture;
+}
+
+
+SDL_Texture*
+SbRenderStats::load_texture( SDL_Renderer* renderer, const std::string& filename )
+{
+  auto lock = lock_renderer();
+  SDL_Texture* texture = IMG_LoadTexture_RW( renderer, SbResourcePack::open( filename ), 1 );
+  texture_created( texture );
+  return texture;
+}
+
+
+void
+SbRenderStats::destroy_texture( SDL_Texture* texture )
+{
+  if ( !texture )
+    return;
+  SbGameContext& context = SbGameContext::current();
+  uint64_t size = texture_size( texture );
+  context.render_current.texture_bytes = ( context.render_current.texture_bytes > size ) ? context.render_current.texture_bytes - size : 0;
+  ++context.render_current.textures_destroyed;
+  if ( context.render_thread )
+    context.render_thread->recording().destroyed.push_back( texture );
+  else
+    SDL_DestroyTexture( texture );
+}
+
+
+void
+SbRenderStats::clear( SDL_Renderer* renderer )
+{
+  SbRenderThread* render_thread = SbGameContext::current().render_thread;
+  if ( render_thread )
+    render_thread->recording().commands.push_back( SbRenderList::Command{ nullptr, SDL_Rect(), SDL_Rect(), true, true } );
+  else
+    SDL_RenderClear( renderer );
+}
+
+
+int
+SbRenderStats::render_copy( SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* destination )
+{
+  SbGameContext& context = SbGameContext::current();
+  ++context.render_current.render_copies;
+  if ( context.render_thread ) {
+    context.render_thread->recording().commands.push_back( SbRenderList::Command{ texture, source ? *source : SDL_Rect(), destination ? *destination : SDL_Rect()
+	  , source == nullptr, destination == nullptr } );
+    return 0;
+  }
+  return SDL_RenderCopy( renderer, texture, source, destination );
+}
+
+
+int
+SbRenderStats::set_render_target( SDL_Renderer* renderer, SDL_Texture* texture )
+{
+  ++SbGameContext::current().render_current.target_switches;
+  auto lock = lock_renderer();
+  return SDL_SetRenderTarget( renderer, texture );
+}
+
+
+void
+SbRenderStats::present( SDL_Renderer* renderer )
+{
+  SbGameContext& context = SbGameContext::current();
+  if ( context.render_thread )
+    context.render_thread->submit();
+  else
+    SDL_RenderPresent( renderer );
+  context.render_last = context.render_current;
+  context.render_current = SbRenderCounters();
+  context.render_current.texture_bytes = context.render_last.texture_bytes;
+  ++context.frames;
+}
+
+
+const SbRenderCounters&
+SbRenderStats::current()
+{
+  return SbGameContext::current().render_current;
+}
+
+
+const SbRenderCounters&
+SbRenderStats::last_frame()
+{
+  return SbGameContext::current().render_last;
+}
+
+
+uint64_t
+SbRenderStats::frame_number()
+{
+  return SbGameContext::current().frames;
+}
+
+
+std::unique_lock<std::recursive_mutex>
+SbRenderStats::lock_renderer()
+{
+  SbRenderThread* render_thread = SbGameContext::current().render_thread;
+  if ( !render_thread )
+    return std::unique_lock<std::recursive_mutex>();
+  return std::unique_lock<std::recursive_mutex>( render_thread->renderer_mutex() );
+}
+
+
+std::unique_lock<std::mutex>
+SbRenderStats::lock_present()
+{
+  SbRenderThread* render_thread = SbGameContext::current().render_thread;
+  if ( !render_thread )
+    return std::unique_lock<std::mutex>();
+  return std::unique_lock<std::mutex>( render_thread->present_mutex() );
+}
+
+
+void
+SbRenderStats::texture_created( SDL_Texture* texture )
+{
+  if ( !texture )
+    return;
+  SbRenderCounters& counters = SbGameContext::current().render_current;
+  ++counters.textures_created;
+  counters.texture_bytes += texture_size( texture );
+}
+
+
+uint64_t
+SbRenderStats::texture_size( SDL_Texture* texture )
+{
+  Uint32 format = 0;
+  int width = 0, height = 0;
+  if ( SDL_QueryTexture( texture, &format, nullptr, &width, &height ) != 0 )
+    return 0;
+  uint64_t bytes_per_pixel = SDL_BYTESPERPIXEL( format );
+  if ( bytes_per_pixel == 0 )   // FOURCC/unknown formats, assume 32 bit
+    bytes_per_pixel = 4;
+  return bytes_per_pixel * width * height;
+}
@@ -0,0 +1,61 @@
+/*! \file SbRenderStats.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBRENDERSTATS_H
+#define SBRENDERSTATS_H
+
+#include <cstdint>
+#include <string>
+#include <mutex>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+/*! Counters for the SDL work issued in one frame. texture_bytes is not reset between frames, it is the estimated size of all textures alive.
+ */
+struct SbRenderCounters
+{
+  uint32_t render_copies = 0;
+  uint32_t textures_created = 0;
+  uint32_t textures_destroyed = 0;
+  uint32_t target_switches = 0;
+  uint64_t texture_bytes = 0;
+};
+
+
+/*! Thin wrappers around the renderer calls used by SbTexture and the game loops that count what each frame does.
+  present() closes the frame: the counters of the finished frame are available from last_frame() until the next present(). The counters belong to the current SbGameContext.
+  While the context has an SbRenderThread, clear(), render_copy() and destroy_texture() are recorded for it and present() submits the frame to it; the other calls take the renderer lock.
+ */
+class SbRenderStats
+{
+ public:
+  static SDL_Texture* create_texture( SDL_Renderer* renderer, Uint32 format, int access, int width, int height );
+  static SDL_Texture* create_texture( SDL_Renderer* renderer, SDL_Surface* surface );
+  static SDL_Texture* load_texture( SDL_Renderer* renderer, const std::string& filename );
+  static void destroy_texture( SDL_Texture* texture );
+  static void clear( SDL_Renderer* renderer );
+  static int render_copy( SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* source, const SDL_Rect* destination );
+  static int set_render_target( SDL_Renderer* renderer, SDL_Texture* texture );
+  static void present( SDL_Renderer* renderer );
+
+  static const SbRenderCounters& current();
+  static const SbRenderCounters& last_frame();
+  static uint64_t frame_number();
+
+  /*! Hold while using the renderer directly. Locks only while the current SbGameContext has an SbRenderThread.
+   */
+  static std::unique_lock<std::recursive_mutex> lock_renderer();
+  /*! Hold, after lock_renderer(), while changing the window the renderer presents to. Locks only while the current SbGameContext has an SbRenderThread.
+   */
+  static std::unique_lock<std::mutex> lock_present();
+
+ private:
+  static uint64_t texture_size( SDL_Texture* texture );
+  static void texture_created( SDL_Texture* texture );
+};
+
+
+#endif  // SBRENDERSTATS_H
@@ -0,0 +1,105 @@
+/*! \file SbRenderThread.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+
+#include "SbGameContext.h"
+
+#include "SbRenderThread.h"
+
+
+SbRenderThread::SbRenderThread(SDL_Renderer* renderer)
+  : context_( SbGameContext::current() )
+  , renderer_(renderer)
+{
+  if ( context_.render_thread )
+    throw std::runtime_error("[SbRenderThread::SbRenderThread] Error: the game already has a render thread");
+  context_.render_thread = this;
+  thread_ = std::thread( &SbRenderThread::run, this );
+}
+
+
+
+SbRenderThread::~SbRenderThread()
+{
+  finish();
+  {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    stop_ = true;
+  }
+  submitted_.notify_one();
+  thread_.join();
+  context_.render_thread = nullptr;
+  // what was recorded after the last present() is dropped, only its textures still need to go
+  for ( SDL_Texture* texture: recording().destroyed )
+    SDL_DestroyTexture( texture );
+  recording().clear();
+}
+
+
+
+void
+SbRenderThread::submit()
+{
+  std::unique_lock<std::mutex> lock( mutex_ );
+  presented_.wait( lock, [this]() { return !busy_; } );
+  recording_ = 1 - recording_;
+  recording().clear();
+  busy_ = true;
+  lock.unlock();
+  submitted_.notify_one();
+}
+
+
+
+void
+SbRenderThread::finish()
+{
+  std::unique_lock<std::mutex> lock( mutex_ );
+  presented_.wait( lock, [this]() { return !busy_; } );
+}
+
+
+
+void
+SbRenderThread::run()
+{
+  while ( true ) {
+    std::unique_lock<std::mutex> lock( mutex_ );
+    submitted_.wait( lock, [this]() { return busy_ || stop_; } );
+    if ( !busy_ )
+      return;
+    SbRenderList& list = lists_[ 1 - recording_ ];
+    lock.unlock();
+
+    execute( list );
+
+    lock.lock();
+    busy_ = false;
+    lock.unlock();
+    presented_.notify_one();
+  }
+}
+
+
+
+void
+SbRenderThread::execute(SbRenderList& list)
+{
+  std::unique_lock<std::recursive_mutex> lock( renderer_mutex_ );
+  for ( const SbRenderList::Command& command: list.commands ) {
+    if ( !command.texture )
+      SDL_RenderClear( renderer_ );
+    else
+      SDL_RenderCopy( renderer_, command.texture, command.whole_source ? nullptr : &command.source
+		      , command.whole_destination ? nullptr : &command.destination );
+  }
+  for ( SDL_Texture* texture: list.destroyed )
+    SDL_DestroyTexture( texture );
+  // the present waits for vsync, let the loop create and update textures meanwhile
+  std::lock_guard<std::mutex> present_lock( present_mutex_ );
+  lock.unlock();
+  SDL_RenderPresent( renderer_ );
+}
@@ -0,0 +1,87 @@
+/*! \file SbRenderThread.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBRENDERTHREAD_H
+#define SBRENDERTHREAD_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <SDL2/SDL.h>
+
+
+/*! The renderer work of one frame, recorded by SbRenderStats while an SbRenderThread runs.
+ */
+struct SbRenderList
+{
+  struct Command
+  {
+    //! nullptr: clear the screen
+    SDL_Texture* texture;
+    SDL_Rect source;
+    SDL_Rect destination;
+    bool whole_source;
+    bool whole_destination;
+  };
+
+  std::vector<Command> commands;
+  //! textures released while recording, destroyed once the commands have run
+  std::vector<SDL_Texture*> destroyed;
+
+  void clear() { commands.clear(); destroyed.clear(); }
+};
+
+
+
+class SbGameContext;
+
+
+/*! Submits and presents frames on a thread of its own, so that the game loop can go on with the next frame while SDL_RenderPresent waits for vsync.
+  It serves the SbGameContext current when it is constructed. While it exists, SbRenderStats::clear(), render_copy() and destroy_texture() only record into one of two SbRenderLists and present() hands the list over: the thread runs it and presents while the loop records the next one into the other list. present() waits if the thread is still busy with the frame before, so the loop is at most one frame ahead.
+  All other renderer calls, e.g. creating textures, take the renderer lock (SbRenderStats::lock_renderer()), which the thread holds while it runs a list, so the renderer state is never used from two threads at once. For SDL_RenderPresent the thread holds the present lock (SbRenderStats::lock_present()) instead, so that the loop can go on creating textures while the present waits for vsync; changes to the window itself, e.g. going fullscreen, take both. SDL only promises rendering from the thread that made the window; this works with the software renderer and renderers that switch their context to the calling thread, hence opt-in.
+  Only one may exist per context. Destroy it before the renderer, the destructor presents the frame in flight.
+ */
+class SbRenderThread
+{
+ public:
+  explicit SbRenderThread(SDL_Renderer* renderer);
+  ~SbRenderThread();
+  SbRenderThread(const SbRenderThread&) = delete;
+  SbRenderThread& operator=(const SbRenderThread&) = delete;
+
+  //! the list being recorded
+  SbRenderList& recording() { return lists_[recording_]; }
+  /*! Hand the recorded list to the thread, after waiting for it to finish the previous one.
+   */
+  void submit();
+  //! wait until the thread has presented everything submitted
+  void finish();
+  std::recursive_mutex& renderer_mutex() { return renderer_mutex_; }
+  std::mutex& present_mutex() { return present_mutex_; }
+
+ private:
+  void run();
+  void execute(SbRenderList& list);
+
+  SbGameContext& context_;
+  SDL_Renderer* renderer_;
+  SbRenderList lists_[2];
+  int recording_ = 0;
+  //! the other list is submitted and not yet presented
+  bool busy_ = false;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable submitted_;
+  std::condition_variable presented_;
+  std::recursive_mutex renderer_mutex_;
+  //! held by the thread while presenting, taken after renderer_mutex_
+  std::mutex present_mutex_;
+  std::thread thread_;
+};
+
+
+#endif  // SBRENDERTHREAD_H
@@ -0,0 +1,183 @@
+/*! \file SbResourcePack.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <stdexcept>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SbResourcePack.h"
+
+
+std::unique_ptr<SbResourcePack> SbResourcePack::mounted_ = nullptr;
+
+namespace {
+  const char magic[4] = {'S','B','P','K'};
+
+  uint64_t align(uint64_t offset) { return ( offset + SbResourcePack::alignment - 1 ) / SbResourcePack::alignment * SbResourcePack::alignment; }
+}
+
+
+
+SbResourcePack::SbResourcePack(const std::string& filename)
+  : filename_(filename)
+{
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if ( fd < 0 )
+    throw std::runtime_error("[SbResourcePack::SbResourcePack] Error: Couldn't open resource pack " + filename + ": " + std::strerror(errno) );
+  struct stat info;
+  if ( fstat( fd, &info ) != 0 || info.st_size < off_t(sizeof(Header)) ) {
+    close(fd);
+    throw std::runtime_error("[SbResourcePack::SbResourcePack] Error: " + filename + " is not a resource pack" );
+  }
+  size_ = info.st_size;
+  void* mapped = mmap( nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close(fd);
+  if ( mapped == MAP_FAILED )
+    throw std::runtime_error("[SbResourcePack::SbResourcePack] Error: Couldn't map " + filename + ": " + std::strerror(errno) );
+  data_ = static_cast<const uint8_t*>(mapped);
+
+  const Header* header = reinterpret_cast<const Header*>(data_);
+  std::string error;
+  if ( std::memcmp( header->magic, magic, sizeof(magic) ) != 0 || header->version != version )
+    error = " is not a resource pack of version " + std::to_string(version);
+  else if ( ( size_ - sizeof(Header) ) / sizeof(Entry) < header->n_entries )
+    error = " is truncated";
+  else {
+    // checked once here, so that find() can trust the index
+    n_entries_ = header->n_entries;
+    entries_ = reinterpret_cast<const Entry*>( data_ + sizeof(Header) );
+    for ( uint32_t i = 0; i < n_entries_ && error.empty(); ++i ) {
+      const Entry& entry = entries_[i];
+      if ( entry.name_offset > size_ || size_ - entry.name_offset < entry.name_length
+	   || entry.offset > size_ || size_ - entry.offset < entry.size )
+	error = " is corrupt";
+    }
+  }
+  if ( !error.empty() ) {
+    munmap( const_cast<uint8_t*>(data_), size_ );
+    throw std::runtime_error("[SbResourcePack::SbResourcePack] Error: " + filename + error );
+  }
+}
+
+
+
+SbResourcePack::~SbResourcePack()
+{
+  if ( data_ )
+    munmap( const_cast<uint8_t*>(data_), size_ );
+}
+
+
+
+const uint8_t*
+SbResourcePack::find(const std::string& name, size_t& size) const
+{
+  // same order as std::string, without copying the names out of the mapping
+  auto compare = [this](const Entry& entry, const std::string& n) {
+    int result = std::memcmp( data_ + entry.name_offset, n.data(), std::min<size_t>( entry.name_length, n.size() ) );
+    return ( result != 0 ) ? result : int( entry.name_length > n.size() ) - int( entry.name_length < n.size() );
+  };
+  const Entry* end = entries_ + n_entries_;
+  const Entry* entry = std::lower_bound( entries_, end, name, [&](const Entry& e, const std::string& n) { return compare(e, n) < 0; } );
+  if ( entry == end || compare(*entry, name) != 0 )
+    return nullptr;
+  size = entry->size;
+  return data_ + entry->offset;
+}
+
+
+
+void
+SbResourcePack::write(const std::string& filename, const std::vector<std::string>& files)
+{
+  std::vector<std::string> names( files );
+  std::sort( names.begin(), names.end() );
+  names.erase( std::unique( names.begin(), names.end() ), names.end() );
+
+  std::vector<std::vector<char>> contents;
+  for ( const std::string& name: names ) {
+    std::ifstream file( name, std::ios::binary );
+    if ( !file )
+      throw std::runtime_error("[SbResourcePack::write] Error: Couldn't open file " + name );
+    contents.emplace_back( std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() );
+  }
+
+  std::vector<Entry> entries( names.size() );
+  uint64_t offset = sizeof(Header) + entries.size() * sizeof(Entry);
+  for ( size_t i = 0; i < names.size(); ++i ) {
+    entries.at(i).name_offset = offset;
+    entries.at(i).name_length = names.at(i).size();
+    offset += names.at(i).size();
+  }
+  for ( size_t i = 0; i < names.size(); ++i ) {
+    entries.at(i).offset = offset = align(offset);
+    entries.at(i).size = contents.at(i).size();
+    offset += contents.at(i).size();
+  }
+
+  // written next to the target and renamed over it, as SbLevelFile::write does
+  std::string temporary = filename + ".tmp";
+  std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+  if ( !file )
+    throw std::runtime_error("[SbResourcePack::write] Error: Couldn't open file " + temporary );
+  Header header;
+  std::memcpy( header.magic, magic, sizeof(magic) );
+  header.version = version;
+  header.n_entries = entries.size();
+  header.reserved = 0;
+  file.write( reinterpret_cast<const char*>(&header), sizeof(header) );
+  file.write( reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry) );
+  for ( const std::string& name: names )
+    file.write( name.data(), name.size() );
+  for ( size_t i = 0; i < names.size(); ++i ) {
+    while ( uint64_t(file.tellp()) < entries.at(i).offset )
+      file.put(0);
+    file.write( contents.at(i).data(), contents.at(i).size() );
+  }
+  file.close();
+  if ( !file || std::rename( temporary.c_str(), filename.c_str() ) != 0 ) {
+    std::remove( temporary.c_str() );
+    throw std::runtime_error("[SbResourcePack::write] Error: Couldn't write " + filename );
+  }
+}
+
+
+
+void
+SbResourcePack::mount(const std::string& filename)
+{
+  mounted_ = std::unique_ptr<SbResourcePack>( new SbResourcePack( filename ) );
+}
+
+
+
+void
+SbResourcePack::unmount()
+{
+  mounted_.reset();
+}
+
+
+
+SDL_RWops*
+SbResourcePack::open(const std::string& filename)
+{
+  if ( mounted_ ) {
+    size_t size = 0;
+    const uint8_t* data = mounted_->find( filename, size );
+    if ( data )
+      return SDL_RWFromConstMem( data, size );
+  }
+  return SDL_RWFromFile( filename.c_str(), "rb" );
+}
@@ -0,0 +1,77 @@
+/*! \file SbResourcePack.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBRESOURCEPACK_H
+#define SBRESOURCEPACK_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+
+/*! Read-only archive of resource files, memory mapped so that a resource is read straight out of the mapping.
+  Layout, native byte order:
+  header: "SBPK", version (uint32), number of entries (uint32), reserved (uint32)
+  one Entry per file, sorted by name, then the names, then the file contents, each starting at a multiple of alignment bytes.
+  Entries are named by the path they were packed from, e.g. resources/ball.png, so that the games keep using the same paths. Packs are made with SbPackTool, make resources.pack packs everything in resources/ but the level files.
+ */
+class SbResourcePack
+{
+ public:
+  static const uint32_t version = 1;
+  static const uint32_t alignment = 64;
+
+  SbResourcePack(const std::string& filename);
+  SbResourcePack(const SbResourcePack&) = delete;
+  SbResourcePack& operator=(const SbResourcePack&) = delete;
+  ~SbResourcePack();
+
+  /*! Contents of the entry name, nullptr if the pack has none.
+   */
+  const uint8_t* find(const std::string& name, size_t& size) const;
+  uint32_t size() const { return n_entries_; }
+  const std::string& filename() const { return filename_; }
+
+  static void write(const std::string& filename, const std::vector<std::string>& files);
+
+  /*! Serve open() from the pack in filename until the program ends or unmount(). The pack has to stay mounted while fonts or anything else opened from it are in use.
+   */
+  static void mount(const std::string& filename);
+  static void unmount();
+  static const SbResourcePack* mounted() { return mounted_.get(); }
+  /*! filename from the mounted pack if it is in there, else from disk. Returns nullptr with SDL_GetError set if neither has it, as SDL_RWFromFile does.
+   */
+  static SDL_RWops* open(const std::string& filename);
+
+ private:
+  struct Header
+  {
+    char magic[4];
+    uint32_t version;
+    uint32_t n_entries;
+    uint32_t reserved;
+  };
+
+  struct Entry
+  {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t name_offset;
+    uint32_t name_length;
+  };
+
+  std::string filename_;
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  uint32_t n_entries_ = 0;
+  const Entry* entries_ = nullptr;
+  static std::unique_ptr<SbResourcePack> mounted_;
+};
+
+
+#endif  // SBRESOURCEPACK_H
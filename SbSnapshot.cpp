@@ -0,0 +1,146 @@
+/*! \file SbSnapshot.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+
+#include "SbSnapshot.h"
+
+
+namespace {
+  //! LEB128, 7 bits per byte, high bit set on all but the last byte
+  void put_length(std::vector<uint8_t>& out, size_t value)
+  {
+    while ( value >= 0x80 ) {
+      out.push_back( uint8_t( value | 0x80 ) );
+      value >>= 7;
+    }
+    out.push_back( uint8_t( value ) );
+  }
+}
+
+
+
+SbRewindBuffer::SbRewindBuffer(size_t max_steps, size_t capacity)
+  : ring_(capacity)
+  , steps_(max_steps)
+{
+  if ( max_steps == 0 || capacity == 0 )
+    throw std::runtime_error("[SbRewindBuffer::SbRewindBuffer] Error: needs room for at least one step");
+}
+
+
+
+void
+SbRewindBuffer::clear()
+{
+  newest_.clear();
+  head_ = 0;
+  used_ = 0;
+  first_ = 0;
+  n_steps_ = 0;
+}
+
+
+
+void
+SbRewindBuffer::encode(const std::vector<uint8_t>& older, const std::vector<uint8_t>& newer)
+{
+  // pairs of (zero run, literal run, literal bytes) over older XOR newer
+  encoded_.clear();
+  size_t size = newer.size();
+  size_t i = 0;
+  while ( i < size ) {
+    size_t zeros = i;
+    // most of the snapshot is unchanged, skip it eight bytes at a time
+    while ( zeros + sizeof(uint64_t) <= size && std::memcmp( &older[zeros], &newer[zeros], sizeof(uint64_t) ) == 0 )
+      zeros += sizeof(uint64_t);
+    while ( zeros < size && older[zeros] == newer[zeros] )
+      ++zeros;
+    if ( zeros == size )
+      break;
+    size_t literals = zeros;
+    while ( literals < size && older[literals] != newer[literals] )
+      ++literals;
+    put_length( encoded_, zeros - i );
+    put_length( encoded_, literals - zeros );
+    for ( size_t k = zeros; k < literals; ++k )
+      encoded_.push_back( older[k] ^ newer[k] );
+    i = literals;
+  }
+}
+
+
+
+void
+SbRewindBuffer::drop_oldest()
+{
+  used_ -= steps_.at(first_).length;
+  first_ = ( first_ + 1 ) % steps_.size();
+  --n_steps_;
+}
+
+
+
+void
+SbRewindBuffer::push(const SbSnapshot& snapshot)
+{
+  const std::vector<uint8_t>& data = snapshot.data();
+  if ( newest_.size() != data.size() ) {
+    clear();
+    newest_ = data;
+    return;
+  }
+  encode( newest_, data );
+  if ( encoded_.size() > ring_.size() ) {
+    clear();
+    newest_ = data;
+    return;
+  }
+  while ( n_steps_ == steps_.size() || used_ + encoded_.size() > ring_.size() )
+    drop_oldest();
+  size_t first_part = std::min( encoded_.size(), ring_.size() - head_ );
+  std::memcpy( ring_.data() + head_, encoded_.data(), first_part );
+  std::memcpy( ring_.data(), encoded_.data() + first_part, encoded_.size() - first_part );
+  steps_.at( ( first_ + n_steps_ ) % steps_.size() ) = Step{ head_, encoded_.size() };
+  ++n_steps_;
+  head_ = ( head_ + encoded_.size() ) % ring_.size();
+  used_ += encoded_.size();
+  std::memcpy( newest_.data(), data.data(), data.size() );
+}
+
+
+
+bool
+SbRewindBuffer::step_back(SbSnapshot& snapshot)
+{
+  if ( n_steps_ == 0 )
+    return false;
+  const Step step = steps_.at( ( first_ + n_steps_ - 1 ) % steps_.size() );
+  size_t read = 0;
+  auto next_byte = [&]() { return ring_[ ( step.start + read++ ) % ring_.size() ]; };
+  auto next_length = [&]() {
+    size_t value = 0;
+    for ( int shift = 0; ; shift += 7 ) {
+      uint8_t b = next_byte();
+      value |= size_t( b & 0x7F ) << shift;
+      if ( !( b & 0x80 ) )
+	return value;
+    }
+  };
+  size_t position = 0;
+  while ( read < step.length ) {
+    position += next_length();
+    size_t literals = next_length();
+    if ( position + literals > newest_.size() )
+      throw std::runtime_error("[SbRewindBuffer::step_back] Error: damaged step");
+    for ( size_t k = 0; k < literals; ++k )
+      newest_[ position++ ] ^= next_byte();
+  }
+  head_ = step.start;
+  used_ -= step.length;
+  --n_steps_;
+  snapshot.assign( newest_ );
+  return true;
+}
@@ -0,0 +1,97 @@
+/*! \file SbSnapshot.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBSNAPSHOT_H
+#define SBSNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+
+/*! The mutable state of a game as a flat byte buffer: objects write their fields in a fixed order with write() and read them back in the same order with read().
+  clear() keeps the memory, so taking a snapshot every frame does not allocate once the buffer has grown to size.
+ */
+class SbSnapshot
+{
+ public:
+  void clear() { data_.clear(); position_ = 0; }
+  //! start reading from the beginning
+  void rewind() { position_ = 0; }
+
+  template <typename T>
+    void write(const T& value)
+  {
+    static_assert( std::is_trivially_copyable<T>::value, "SbSnapshot only holds plain values" );
+    size_t size = data_.size();
+    data_.resize( size + sizeof(T) );
+    std::memcpy( data_.data() + size, &value, sizeof(T) );
+  }
+
+  template <typename T>
+    void read(T& value)
+  {
+    static_assert( std::is_trivially_copyable<T>::value, "SbSnapshot only holds plain values" );
+    if ( position_ + sizeof(T) > data_.size() )
+      throw std::runtime_error("[SbSnapshot::read] Error: read past the end of the snapshot");
+    std::memcpy( &value, data_.data() + position_, sizeof(T) );
+    position_ += sizeof(T);
+  }
+
+  size_t size() const { return data_.size(); }
+  const std::vector<uint8_t>& data() const { return data_; }
+  void assign(const std::vector<uint8_t>& data) { data_.assign( data.begin(), data.end() ); position_ = 0; }
+
+ private:
+  std::vector<uint8_t> data_;
+  size_t position_ = 0;
+};
+
+
+
+/*! Keeps the last max_steps snapshots of a game for rewinding, in at most capacity bytes.
+  Only the newest snapshot is kept whole. Each older one is stored as its difference to the next: the two are XORed, which leaves zeros wherever nothing changed, and the runs of zeros are replaced by their length. Most of a frame's state does not change from one frame to the next, so a step takes a few dozen bytes. step_back() undoes the newest step.
+  A snapshot of a different size (e.g. another level) starts the buffer over.
+ */
+class SbRewindBuffer
+{
+ public:
+  SbRewindBuffer(size_t max_steps = 300, size_t capacity = 1 << 20);
+
+  void push(const SbSnapshot& snapshot);
+  /*! Drops the newest snapshot and puts the one before into snapshot. Returns false, leaving snapshot alone, if there is none.
+   */
+  bool step_back(SbSnapshot& snapshot);
+  void clear();
+  size_t steps() const { return n_steps_; }
+  //! bytes taken by the steps
+  size_t bytes() const { return used_; }
+
+ private:
+  struct Step
+  {
+    size_t start;
+    size_t length;
+  };
+
+  void encode(const std::vector<uint8_t>& older, const std::vector<uint8_t>& newer);
+  void drop_oldest();
+
+  std::vector<uint8_t> newest_;
+  //! encoded step, reused
+  std::vector<uint8_t> encoded_;
+  //! the steps, one after the other, wrapping around at the end
+  std::vector<uint8_t> ring_;
+  size_t head_ = 0;
+  size_t used_ = 0;
+  std::vector<Step> steps_;
+  size_t first_ = 0;
+  size_t n_steps_ = 0;
+};
+
+
+#endif  // SBSNAPSHOT_H
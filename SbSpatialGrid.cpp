@@ -0,0 +1,113 @@
+/*! \file SbSpatialGrid.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "SbSpatialGrid.h"
+
+
+SbSpatialGrid::SbSpatialGrid(int cell_size)
+  : cell_size_(cell_size)
+{
+  if ( cell_size_ <= 0 )
+    throw std::runtime_error("[SbSpatialGrid::SbSpatialGrid] Error: invalid cell size " + std::to_string(cell_size) );
+}
+
+
+
+void
+SbSpatialGrid::reset(const SbDimension& dimension)
+{
+  columns_ = std::max( 1, ( dimension.w + cell_size_ - 1 ) / cell_size_ );
+  rows_ = std::max( 1, ( dimension.h + cell_size_ - 1 ) / cell_size_ );
+  cells_.clear();
+  cells_.resize( columns_ * rows_ );
+  n_objects_ = 0;
+}
+
+
+
+SbSpatialGrid::CellRange
+SbSpatialGrid::cells(const SDL_Rect& box) const
+{
+  // floor division, boxes may start left of or above the level
+  auto cell_of = [this](int position, int n_cells) {
+    int cell = ( position >= 0 ) ? position / cell_size_ : -( ( cell_size_ - 1 - position ) / cell_size_ );
+    return std::min( std::max( cell, 0 ), n_cells - 1 );
+  };
+  CellRange range;
+  range.first_column = cell_of( box.x, columns_ );
+  range.last_column = cell_of( box.x + box.w, columns_ );
+  range.first_row = cell_of( box.y, rows_ );
+  range.last_row = cell_of( box.y + box.h, rows_ );
+  return range;
+}
+
+
+
+void
+SbSpatialGrid::insert(SbObject* object)
+{
+  if ( cells_.empty() )
+    throw std::runtime_error("[SbSpatialGrid::insert] Error: grid has no size, call reset() first" );
+  CellRange range = cells( object->bounding_rect() );
+  for ( int row = range.first_row; row <= range.last_row; ++row )
+    for ( int column = range.first_column; column <= range.last_column; ++column )
+      cells_[ row * columns_ + column ].push_back( object );
+  ++n_objects_;
+}
+
+
+
+void
+SbSpatialGrid::remove(SbObject* object)
+{
+  if ( cells_.empty() )
+    return;
+  bool found = false;
+  CellRange range = cells( object->bounding_rect() );
+  for ( int row = range.first_row; row <= range.last_row; ++row ) {
+    for ( int column = range.first_column; column <= range.last_column; ++column ) {
+      std::vector<SbObject*>& cell = cells_[ row * columns_ + column ];
+      auto entry = std::find( cell.begin(), cell.end(), object );
+      if ( entry != cell.end() ) {
+	*entry = cell.back();
+	cell.pop_back();
+	found = true;
+      }
+    }
+  }
+  if ( found )
+    --n_objects_;
+}
+
+
+
+void
+SbSpatialGrid::query(const SDL_Rect& box, std::vector<SbObject*>& result) const
+{
+  result.clear();
+  if ( cells_.empty() )
+    return;
+  CellRange range = cells( box );
+  for ( int row = range.first_row; row <= range.last_row; ++row ) {
+    for ( int column = range.first_column; column <= range.last_column; ++column ) {
+      const std::vector<SbObject*>& cell = cells_[ row * columns_ + column ];
+      result.insert( result.end(), cell.begin(), cell.end() );
+    }
+  }
+  // objects spanning several cells are found several times
+  std::sort( result.begin(), result.end(), [](const SbObject* lhs, const SbObject* rhs) {
+      SDL_Rect l = lhs->bounding_rect(), r = rhs->bounding_rect();
+      if ( l.y != r.y ) return l.y < r.y;
+      if ( l.x != r.x ) return l.x < r.x;
+      if ( l.h != r.h ) return l.h < r.h;
+      if ( l.w != r.w ) return l.w < r.w;
+      return lhs < rhs;
+    } );
+  result.erase( std::unique( result.begin(), result.end() ), result.end() );
+}
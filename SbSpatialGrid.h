@@ -0,0 +1,51 @@
+/*! \file SbSpatialGrid.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBSPATIALGRID_H
+#define SBSPATIALGRID_H
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "SbObject.h"
+
+
+/*! Uniform grid over a level for finding the static objects near a box without looking at all of them.
+  Every object is listed in all cells its bounding_rect overlaps; objects outside the level are kept in the border cells. The grid does not own the objects and does not notice when they move: remove() them before changing their bounding_rect and insert() them again afterwards.
+ */
+class SbSpatialGrid
+{
+ public:
+  SbSpatialGrid(int cell_size = 128);
+
+  /*! Drop all objects and cover a level of the given dimension.
+   */
+  void reset(const SbDimension& dimension);
+  void insert(SbObject* object);
+  void remove(SbObject* object);
+  /*! Objects whose bounding_rect may overlap box, each once, ordered by position so that the result does not depend on insertion order.
+    result is cleared first, pass the same vector every frame to avoid allocations.
+   */
+  void query(const SDL_Rect& box, std::vector<SbObject*>& result) const;
+  size_t size() const { return n_objects_; }
+
+ private:
+  struct CellRange
+  {
+    int first_column, last_column, first_row, last_row;
+  };
+
+  CellRange cells(const SDL_Rect& box) const;
+
+  int cell_size_;
+  int columns_ = 0;
+  int rows_ = 0;
+  size_t n_objects_ = 0;
+  std::vector<std::vector<SbObject*>> cells_;
+};
+
+
+#endif  // SBSPATIALGRID_H
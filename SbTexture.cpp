@@ -11,6 +11,8 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_image.h>
 
+#include "SbRenderStats.h"
+#include "SbPixelCache.h"
 #include "SbTexture.h"
 
 
@@ -28,7 +30,7 @@ SbTexture::clear()
 {
   if ( texture_ )
     {
-      SDL_DestroyTexture( texture_ );
+      SbRenderStats::destroy_texture( texture_ );
       texture_ = nullptr;
       width_ = 0;
       height_ = 0;
@@ -40,7 +42,8 @@ SbTexture::clear()
 SbTexture*
 SbTexture::from_file(SDL_Renderer* renderer, const std::string& filename, int width, int height )
 {
-  texture_ = IMG_LoadTexture(renderer, filename.c_str());
+  clear();
+  texture_ = SbPixelCache::load_texture(renderer, filename);
   
   if( texture_ == nullptr )
     throw std::runtime_error("Unable to create texture from " + filename + " " + SDL_GetError() );
@@ -69,18 +72,20 @@ SbTexture*
 SbTexture::from_rectangle( SDL_Renderer* renderer, int width, int height, const SDL_Color& color )
 {
   clear();
-  texture_ = SDL_CreateTexture(renderer, 0, SDL_TEXTUREACCESS_TARGET, width, height);
+  // drawn into on the spot, keep a render thread off the renderer until done
+  auto lock = SbRenderStats::lock_renderer();
+  texture_ = SbRenderStats::create_texture(renderer, 0, SDL_TEXTUREACCESS_TARGET, width, height);
   if (texture_ == nullptr) 
     throw std::runtime_error("Failed to create texture " + std::string( SDL_GetError() ));
   
   SDL_RenderClear(renderer);
-  SDL_SetRenderTarget(renderer, texture_);
+  SbRenderStats::set_render_target(renderer, texture_);
   SDL_SetRenderDrawColor( renderer, color.r, color.g, color.b, color.a );
   SDL_Rect sourceRect = {0,0,width,height};
   int check = SDL_RenderFillRect( renderer, &sourceRect );
   if ( check != 0 )
     throw std::runtime_error("Couldn't render rectangle: " + std::string( SDL_GetError() ));
-  SDL_SetRenderTarget(renderer, nullptr);
+  SbRenderStats::set_render_target(renderer, nullptr);
   SDL_SetRenderDrawColor( renderer, 0x00, 0x00, 0x00, 0xFF );
   SDL_RenderClear(renderer);
 
@@ -99,7 +104,7 @@ SbTexture::from_text( SDL_Renderer* renderer, const std::string& text, TTF_Font*
   if (surf == nullptr)
     throw std::runtime_error("Failed to create surface from text: " + std::string( SDL_GetError() ));
 
-  texture_ = SDL_CreateTextureFromSurface(renderer, surf);
+  texture_ = SbRenderStats::create_texture(renderer, surf);
   SDL_FreeSurface(surf);
   if (texture_ == nullptr) 
     throw std::runtime_error("Failed to create texture " + std::string( SDL_GetError() ));
@@ -121,5 +126,5 @@ SbTexture::render( SDL_Renderer* renderer, int x, int y, SDL_Rect* sourceRect)
 void
 SbTexture::render( SDL_Renderer* renderer, SDL_Rect *bounding_rect, SDL_Rect* sourceRect)
 {
-  SDL_RenderCopy( renderer, texture_, sourceRect, bounding_rect );
+  SbRenderStats::render_copy( renderer, texture_, sourceRect, bounding_rect );
 }
@@ -0,0 +1,108 @@
+/*! \file SbTileOptimizer.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+
+#include "SbTileOptimizer.h"
+
+
+namespace {
+  /*! Greedy rectangles over the covered cells of a columns x rows grid, cell (c,r) is covered[r*columns+c].
+    With rows_first the rectangles grow right then down, else down then right. Returns column/row index ranges as SDL_Rect.
+   */
+  std::vector<SDL_Rect> decompose(std::vector<uint8_t> covered, int columns, int rows, bool rows_first)
+  {
+    std::vector<SDL_Rect> result;
+    auto cell = [&](int major, int minor) -> uint8_t& {
+      return rows_first ? covered[ major * columns + minor ] : covered[ minor * columns + major ];
+    };
+    int n_major = rows_first ? rows : columns;
+    int n_minor = rows_first ? columns : rows;
+    for ( int major = 0; major < n_major; ++major ) {
+      for ( int minor = 0; minor < n_minor; ++minor ) {
+	if ( !cell(major, minor) )
+	  continue;
+	int last_minor = minor;
+	while ( last_minor + 1 < n_minor && cell(major, last_minor + 1) )
+	  ++last_minor;
+	int last_major = major;
+	while ( last_major + 1 < n_major ) {
+	  bool full = true;
+	  for ( int m = minor; m <= last_minor && full; ++m )
+	    full = cell(last_major + 1, m);
+	  if ( !full )
+	    break;
+	  ++last_major;
+	}
+	for ( int a = major; a <= last_major; ++a )
+	  for ( int b = minor; b <= last_minor; ++b )
+	    cell(a, b) = 0;
+	if ( rows_first )
+	  result.push_back( SDL_Rect{ minor, major, last_minor - minor + 1, last_major - major + 1 } );
+	else
+	  result.push_back( SDL_Rect{ major, minor, last_major - major + 1, last_minor - minor + 1 } );
+      }
+    }
+    return result;
+  }
+}
+
+
+
+std::vector<SbRectangle>
+SbTileOptimizer::optimize(const SbRectangle* boxes, size_t n_boxes, const SbDimension& dimension)
+{
+  if ( n_boxes < 2 || n_boxes > max_tiles || dimension.w <= 0 || dimension.h <= 0 )
+    return std::vector<SbRectangle>( boxes, boxes + n_boxes );
+
+  // pixels as in SbObject::SbObject(SbRectangle, ...)
+  std::vector<SDL_Rect> rects;
+  std::vector<int> xs, ys;
+  for ( size_t i = 0; i < n_boxes; ++i ) {
+    SDL_Rect rect = { static_cast<int>( boxes[i].x * dimension.w ), static_cast<int>( boxes[i].y * dimension.h )
+		      , static_cast<int>( boxes[i].w * dimension.w ), static_cast<int>( boxes[i].h * dimension.h ) };
+    if ( rect.w <= 0 || rect.h <= 0 )
+      continue;
+    rects.push_back( rect );
+    xs.push_back( rect.x );
+    xs.push_back( rect.x + rect.w );
+    ys.push_back( rect.y );
+    ys.push_back( rect.y + rect.h );
+  }
+  std::sort( xs.begin(), xs.end() );
+  xs.erase( std::unique( xs.begin(), xs.end() ), xs.end() );
+  std::sort( ys.begin(), ys.end() );
+  ys.erase( std::unique( ys.begin(), ys.end() ), ys.end() );
+  if ( xs.size() < 2 || ys.size() < 2 )
+    return std::vector<SbRectangle>( boxes, boxes + n_boxes );
+
+  // union on the compressed grid, cell (c,r) spans xs[c]..xs[c+1], ys[r]..ys[r+1]
+  const int columns = xs.size() - 1, rows = ys.size() - 1;
+  std::vector<uint8_t> covered( columns * rows, 0 );
+  auto index = [](const std::vector<int>& edges, int position) {
+    return int( std::lower_bound( edges.begin(), edges.end(), position ) - edges.begin() );
+  };
+  for ( const SDL_Rect& rect: rects ) {
+    int first_column = index( xs, rect.x ), end_column = index( xs, rect.x + rect.w );
+    int first_row = index( ys, rect.y ), end_row = index( ys, rect.y + rect.h );
+    for ( int row = first_row; row < end_row; ++row )
+      std::fill( covered.begin() + row * columns + first_column, covered.begin() + row * columns + end_column, 1 );
+  }
+
+  std::vector<SDL_Rect> by_rows = decompose( covered, columns, rows, true );
+  std::vector<SDL_Rect> by_columns = decompose( covered, columns, rows, false );
+  const std::vector<SDL_Rect>& cells = ( by_columns.size() < by_rows.size() ) ? by_columns : by_rows;
+
+  // back to fractions, half a pixel in so that SbObject rounds (towards zero) to the same pixels
+  auto fraction = [](int pixels, int size) { return ( pixels + ( pixels < 0 ? -0.5 : 0.5 ) ) / size; };
+  std::vector<SbRectangle> result;
+  result.reserve( cells.size() );
+  for ( const SDL_Rect& cell: cells ) {
+    int x = xs[cell.x], y = ys[cell.y];
+    int w = xs[cell.x + cell.w] - x, h = ys[cell.y + cell.h] - y;
+    result.emplace_back( fraction( x, dimension.w ), fraction( y, dimension.h ), fraction( w, dimension.w ), fraction( h, dimension.h ) );
+  }
+  return result;
+}
@@ -0,0 +1,27 @@
+/*! \file SbTileOptimizer.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBTILEOPTIMIZER_H
+#define SBTILEOPTIMIZER_H
+
+#include <vector>
+
+#include "SbObject.h"
+
+
+/*! Replaces a set of static tiles by fewer tiles covering exactly the same pixels, without overlaps.
+  The tiles are placed in pixels as SbObject does, the union is taken on the grid of all tile edges (coordinate compression) and split again into rectangles, greedily growing each one right then down, or down then right, whichever gives fewer. Greedy is not always minimal but close for level layouts.
+  The compressed grid grows with the square of the number of tiles, larger sets are returned unchanged.
+ */
+class SbTileOptimizer
+{
+ public:
+  static const size_t max_tiles = 1024;
+
+  static std::vector<SbRectangle> optimize(const SbRectangle* boxes, size_t n_boxes, const SbDimension& dimension);
+};
+
+
+#endif  // SBTILEOPTIMIZER_H
@@ -4,10 +4,28 @@
  */
 
 
+#include "SbGameContext.h"
+
 #include "SbTimer.h"
 
 /*! SbTimer implementation
  */
+Uint32
+SbTimer::now()
+{
+  const SbGameContext& context = SbGameContext::current();
+  return context.fixed_clock ? context.fixed_time : SDL_GetTicks();
+}
+
+
+void
+SbTimer::set_fixed_time(Uint32 ms)
+{
+  SbGameContext& context = SbGameContext::current();
+  context.fixed_clock = true;
+  context.fixed_time = ms;
+}
+
 
 
 void
@@ -23,7 +41,15 @@ void
 SbTimer::start()
 {
   started_ = true;
-  startTime_ = SDL_GetTicks();
+  startTime_ = now();
+}
+
+
+void
+SbTimer::set_time(Uint32 ms, bool running)
+{
+  started_ = running;
+  startTime_ = running ? now() - ms : ms;
 }
 
 
@@ -32,16 +58,16 @@ SbTimer::stop()
 {
   started_ =false;
   // When stopped, the timer will return the time interval between start and stop. This is saved in startTime_ until the timer is restarted.
-  startTime_ = SDL_GetTicks() - startTime_;
+  startTime_ = now() - startTime_;
 }
 
 
 Uint32
-SbTimer::get_time()
+SbTimer::get_time() const
 {
   Uint32 time = 0;
   if ( started_ ) {
-    time = SDL_GetTicks() - startTime_;
+    time = now() - startTime_;
   }
   else {
     time = startTime_;
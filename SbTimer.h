@@ -19,9 +19,19 @@ public:
   void reset();
   /*! All times in ms
    */
-  Uint32 get_time();
-  bool started(){ return started_ ;}
+  Uint32 get_time() const;
+  bool started() const { return started_ ;}
+  /*! Make get_time() return ms from now on, running on if running, e.g. when restoring a snapshot.
+   */
+  void set_time(Uint32 ms, bool running);
 
+  /*! Current time in ms: SDL_GetTicks, unless a fixed time was set in the current SbGameContext.
+   */
+  static Uint32 now();
+  /*! Freeze the clock of all timers of the current SbGameContext at ms until the next call. Recording and replay set it once per frame so that both see the same times.
+   */
+  static void set_fixed_time(Uint32 ms);
+  
 private:
   Uint32 startTime_ = 0;
   bool started_ = false;
@@ -0,0 +1,255 @@
+/*! \file SbTimerWheel.cpp
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#include <algorithm>
+#include <utility>
+
+#include "SbTimer.h"
+
+#include "SbTimerWheel.h"
+
+
+SbTimerWheel::SbTimerWheel()
+{
+  std::fill( heads_, heads_ + levels * slots + 1, -1 );
+}
+
+
+
+SbTimerWheel::Handle
+SbTimerWheel::schedule(Uint32 delay_ms, Callback callback, Uint32 period_ms)
+{
+  int32_t index;
+  if ( free_.empty() ) {
+    index = int32_t( entries_.size() );
+    entries_.emplace_back();
+  }
+  else {
+    index = free_.back();
+    free_.pop_back();
+  }
+  Entry& entry = entries_[index];
+  entry.callback = std::move(callback);
+  entry.expires = now_ + std::max<Uint32>( delay_ms, 1 );
+  entry.period = period_ms;
+  insert( index );
+  ++count_;
+  return ( Handle(entry.generation) << 32 ) | Handle( index + 1 );
+}
+
+
+
+int32_t
+SbTimerWheel::find(Handle handle) const
+{
+  size_t index = size_t( handle & 0xFFFFFFFFu );
+  if ( index == 0 || index > entries_.size() )
+    return -1;
+  const Entry& entry = entries_[index - 1];
+  if ( entry.generation != uint32_t( handle >> 32 ) || entry.list == free_entry || entry.list == cancelled )
+    return -1;
+  return int32_t( index - 1 );
+}
+
+
+
+bool
+SbTimerWheel::pending(Handle handle) const
+{
+  return find( handle ) >= 0;
+}
+
+
+
+Uint32
+SbTimerWheel::remaining(Handle handle) const
+{
+  int32_t index = find( handle );
+  if ( index < 0 || entries_[index].list == running )
+    return 0;
+  return Uint32( entries_[index].expires - now_ );
+}
+
+
+
+bool
+SbTimerWheel::cancel(Handle handle)
+{
+  int32_t index = find( handle );
+  if ( index < 0 )
+    return false;
+  --count_;
+  if ( entries_[index].list == running ) {
+    // its callback is on the stack, run_due() releases it afterwards
+    entries_[index].list = cancelled;
+    return true;
+  }
+  unlink( index );
+  release( index );
+  return true;
+}
+
+
+
+void
+SbTimerWheel::clear()
+{
+  for ( int32_t index = 0; index < int32_t( entries_.size() ); ++index ) {
+    Entry& entry = entries_[index];
+    if ( entry.list == running )
+      entry.list = cancelled;
+    else if ( entry.list >= 0 ) {
+      unlink( index );
+      release( index );
+    }
+  }
+  count_ = 0;
+}
+
+
+
+void
+SbTimerWheel::update()
+{
+  Uint32 clock = SbTimer::now();
+  Uint32 elapsed = clock - clock_;
+  bool first = !clock_started_;
+  clock_ = clock;
+  clock_started_ = true;
+  // the clock went back, e.g. a replay starting
+  if ( first || elapsed > 0x80000000u )
+    return;
+  advance( elapsed );
+}
+
+
+
+void
+SbTimerWheel::advance(Uint32 ms)
+{
+  for ( ; ms > 0; --ms ) {
+    if ( count_ == 0 ) {
+      now_ += ms;
+      return;
+    }
+    ++now_;
+    int index = int( now_ & ( slots - 1 ) );
+    if ( index == 0 && cascade(1) == 0 && cascade(2) == 0 )
+      cascade(3);
+    int32_t head = heads_[index];
+    if ( head < 0 )
+      continue;
+    // hand the slot over to the due list, so that callbacks can cancel the timers after them
+    heads_[due] = head;
+    heads_[index] = -1;
+    for ( int32_t entry = head; entry >= 0; entry = entries_[entry].next )
+      entries_[entry].list = due;
+    run_due();
+  }
+}
+
+
+
+int
+SbTimerWheel::cascade(int level)
+{
+  int index = int( ( now_ >> ( level * level_bits ) ) & ( slots - 1 ) );
+  int list = level * slots + index;
+  int32_t entry = heads_[list];
+  heads_[list] = -1;
+  while ( entry >= 0 ) {
+    int32_t next = entries_[entry].next;
+    insert( entry );
+    entry = next;
+  }
+  return index;
+}
+
+
+
+void
+SbTimerWheel::run_due()
+{
+  while ( heads_[due] >= 0 ) {
+    int32_t index = heads_[due];
+    unlink( index );
+    Entry& entry = entries_[index];
+    if ( entry.period == 0 ) {
+      // released first, so that the callback can neither cancel nor reschedule it
+      Callback callback = std::move( entry.callback );
+      release( index );
+      --count_;
+      callback();
+      continue;
+    }
+    entry.list = running;
+    entry.callback();
+    if ( entry.list == cancelled ) {
+      release( index );
+      continue;
+    }
+    entry.expires += entry.period;
+    insert( index );
+  }
+}
+
+
+
+void
+SbTimerWheel::insert(int32_t index)
+{
+  Entry& entry = entries_[index];
+  // expires is never before now_: a timer cascaded into the current slot runs right after the cascade
+  uint64_t expires = std::max( entry.expires, now_ );
+  uint64_t delay = expires - now_;
+  int level = 0;
+  while ( level < levels - 1 && delay >= ( uint64_t(1) << ( ( level + 1 ) * level_bits ) ) )
+    ++level;
+  if ( level == levels - 1 && delay >= ( uint64_t(1) << ( levels * level_bits ) ) )
+    // beyond the top level, wait in its last slot and come down from there
+    expires = now_ + ( uint64_t(1) << ( levels * level_bits ) ) - 1;
+  link( index, level * slots + int( ( expires >> ( level * level_bits ) ) & ( slots - 1 ) ) );
+}
+
+
+
+void
+SbTimerWheel::link(int32_t index, int list)
+{
+  Entry& entry = entries_[index];
+  entry.list = list;
+  entry.prev = -1;
+  entry.next = heads_[list];
+  if ( entry.next >= 0 )
+    entries_[entry.next].prev = index;
+  heads_[list] = index;
+}
+
+
+
+void
+SbTimerWheel::unlink(int32_t index)
+{
+  Entry& entry = entries_[index];
+  if ( entry.prev >= 0 )
+    entries_[entry.prev].next = entry.next;
+  else
+    heads_[entry.list] = entry.next;
+  if ( entry.next >= 0 )
+    entries_[entry.next].prev = entry.prev;
+  entry.next = entry.prev = -1;
+}
+
+
+
+void
+SbTimerWheel::release(int32_t index)
+{
+  Entry& entry = entries_[index];
+  entry.callback = nullptr;
+  entry.list = free_entry;
+  ++entry.generation;
+  free_.push_back( index );
+}
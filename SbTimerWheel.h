@@ -0,0 +1,99 @@
+/*! \file SbTimerWheel.h
+  part of SDL2-basic
+  author: Ulrike Hager
+ */
+
+#ifndef SBTIMERWHEEL_H
+#define SBTIMERWHEEL_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <functional>
+
+#include <SDL2/SDL.h>
+
+
+/*! Delayed and repeating callbacks, run by the game loop on its own thread when it calls update(), instead of on SDL's timer thread.
+  A hierarchical timer wheel with 1 ms resolution: four levels of 64 slots each cover 64 ms, 4 s, 4.5 min and 4.7 h, a timer goes into the slot of the lowest level its delay fits in, later ones wait in the top level. Every millisecond the wheel runs the timers of the current slot of level 0; whenever a level has gone round once, the next slot of the level above is spread over the levels below. Scheduling, cancelling and running a timer take constant time, a millisecond without timers costs a few instructions, and timers far off are only touched up to three times on the way down.
+  The wheel keeps its own time: update() adds the time passed on the SbTimer clock since the last call, so timers follow recordings and replays; the clock jumping back, e.g. when a replay starts, counts as no time passing.
+ */
+class SbTimerWheel
+{
+ public:
+  //! identifies a scheduled timer, 0 is none
+  typedef uint64_t Handle;
+  typedef std::function<void()> Callback;
+
+  SbTimerWheel();
+  SbTimerWheel(const SbTimerWheel&) = delete;
+  SbTimerWheel& operator=(const SbTimerWheel&) = delete;
+
+  /*! Run callback delay_ms from now, then every period_ms if that is not 0. A delay of 0 runs it at the next update() that moves time on. Callbacks may schedule and cancel timers, including their own.
+   */
+  Handle schedule(Uint32 delay_ms, Callback callback, Uint32 period_ms = 0);
+  /*! Stop a timer. Returns false if it has already run (and does not repeat) or was cancelled.
+   */
+  bool cancel(Handle handle);
+  bool pending(Handle handle) const;
+  //! ms until the timer runs next, 0 if it is not pending
+  Uint32 remaining(Handle handle) const;
+  //! cancel all timers
+  void clear();
+  /*! Move on by the time passed on the SbTimer clock since the last call and run what is due. The first call only reads the clock.
+   */
+  void update();
+  /*! Move on by ms and run what is due, in the order of expiry.
+   */
+  void advance(Uint32 ms);
+  //! ms the wheel has moved on since construction
+  uint64_t time() const { return now_; }
+  //! timers scheduled
+  size_t size() const { return count_; }
+
+ private:
+  static const int level_bits = 6;
+  static const int slots = 1 << level_bits;
+  static const int levels = 4;
+  //! list index of the timers being run
+  static const int due = levels * slots;
+  //! list values of timers not in any list
+  static const int32_t free_entry = -1;
+  static const int32_t running = -2;
+  static const int32_t cancelled = -3;
+
+  struct Entry
+  {
+    Callback callback;
+    uint64_t expires = 0;
+    Uint32 period = 0;
+    uint32_t generation = 0;
+    int32_t next = -1;
+    int32_t prev = -1;
+    //! slot (level * slots + index), due, or one of the negative values
+    int32_t list = free_entry;
+  };
+
+  //! index of the entry of a pending timer, -1 if there is none
+  int32_t find(Handle handle) const;
+  void insert(int32_t entry);
+  void link(int32_t entry, int list);
+  void unlink(int32_t entry);
+  void release(int32_t entry);
+  //! move the timers of a slot to the levels below, returns the index of the slot
+  int cascade(int level);
+  void run_due();
+
+  //! a deque, so that a callback scheduling timers does not move the entry being run
+  std::deque<Entry> entries_;
+  std::vector<int32_t> free_;
+  int32_t heads_[levels * slots + 1];
+  uint64_t now_ = 0;
+  //! SbTimer clock at the last update()
+  Uint32 clock_ = 0;
+  bool clock_started_ = false;
+  size_t count_ = 0;
+};
+
+
+#endif  // SBTIMERWHEEL_H
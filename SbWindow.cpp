@@ -5,25 +5,40 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <fstream>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "SbEventSource.h"
+#include "SbResourcePack.h"
+#include "SbRenderStats.h"
 #include "SbWindow.h"
 
 
+namespace {
+  bool headless_ = false;
+}
+
+
 SbWindow::SbWindow(std::string title, int width, int height)
   : dimension_{width, height}
 {
-  SDL_Window* win =  SDL_CreateWindow( "Basic half-Pong", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+  Uint32 window_flags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE;
+  Uint32 renderer_flags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE;
+  if ( headless_ ) {
+    window_flags = SDL_WINDOW_HIDDEN;
+    renderer_flags = SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE;
+  }
+  SDL_Window* win =  SDL_CreateWindow( "Basic half-Pong", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, window_flags);
   if( win == nullptr ){
     std::cerr << "Could not create window. SDL_Error: " <<  SDL_GetError()  << std::endl;
     exit(1);
   }
   window_ = std::unique_ptr<SDL_Window, DeleteWindow>( win, DeleteWindow() );
   
-  SDL_Renderer* ren = SDL_CreateRenderer( window_.get(), -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+  SDL_Renderer* ren = SDL_CreateRenderer( window_.get(), -1, renderer_flags);
   if( ren == nullptr ){
     std::cerr << "Could not create renderer. SDL_Error: " <<  SDL_GetError() << std::endl;
     exit(1);
@@ -36,11 +51,23 @@ SbWindow::SbWindow(std::string title, int width, int height)
 
 SbWindow::~SbWindow()
 {
+  render_thread_.reset(nullptr);
   renderer_.reset(nullptr);
   window_.reset(nullptr);
 }
 
 
+void
+SbWindow::set_render_thread(bool on)
+{
+  if ( on && !render_thread_ )
+    render_thread_ = std::unique_ptr<SbRenderThread>( new SbRenderThread( renderer_.get() ) );
+  else if ( !on )
+    render_thread_.reset(nullptr);
+}
+
+
+
 int
 SbWindow::handle_event(const SDL_Event& event)
 {
@@ -53,9 +80,11 @@ SbWindow::handle_event(const SDL_Event& event)
     }
   }
   else if( event.type == SDL_KEYDOWN && event.key.repeat == 0 && event.key.keysym.sym == SDLK_f ) {
-    const Uint8 *state = SDL_GetKeyboardState(nullptr);
+    const Uint8 *state = SbEventSource::keyboard_state();
     if (state[SDL_SCANCODE_LALT]) return 0;  // toggles fps display
 
+    auto lock = SbRenderStats::lock_renderer();
+    auto present_lock = SbRenderStats::lock_present();
     if ( is_fullscreen ) {
       SDL_SetWindowFullscreen( window_.get(), SDL_FALSE );
       SDL_GetWindowSize( window_.get(), &dimension_.w, &dimension_.h );
@@ -73,8 +102,11 @@ SbWindow::handle_event(const SDL_Event& event)
 
 
 
-void sdl_init()
+void sdl_init(bool headless)
 {
+  headless_ = headless;
+  if ( headless_ )
+    SDL_setenv( "SDL_VIDEODRIVER", "dummy", 1 );
  if( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_JOYSTICK | SDL_INIT_GAMECONTROLLER ) < 0 ) {
     std::cerr << "SDL could not initialize! SDL_Error: " <<  SDL_GetError() << std::endl;
     exit(1);
@@ -96,6 +128,22 @@ void sdl_init()
     SDL_Quit();
     exit(1);
   }
+
+  // fonts and images come out of the resource pack if there is one (make resources.pack), else from resources/
+  if ( std::ifstream( "resources.pack" ).good() ) {
+    try {
+      SbResourcePack::mount( "resources.pack" );
+    }
+    catch (const std::exception& expt) {
+      std::cerr << expt.what() << ", reading resources/ instead" << std::endl;
+    }
+  }
+}
+
+
+bool sdl_headless()
+{
+  return headless_;
 }
 
 
@@ -104,4 +152,5 @@ void sdl_quit()
   IMG_Quit();
   TTF_Quit();
   SDL_Quit();
+  SbResourcePack::unmount();
 }
@@ -14,6 +14,7 @@
 #include <SDL2/SDL.h>
 
 #include "SbObject.h"
+#include "SbRenderThread.h"
 
 struct DeleteWindow
 {
@@ -59,17 +60,25 @@ class SbWindow
   int width() const {return dimension_.w;}
   // bool new_size() { return new_size_; }
   const SbDimension* get_dimension() const { return &dimension_;}
+  /*! Present frames from an SbRenderThread, see there.
+   */
+  void set_render_thread(bool on);
   
  private:
   std::unique_ptr<SDL_Renderer, DeleteRenderer> renderer_ = nullptr;
   std::unique_ptr<SDL_Window, DeleteWindow> window_ = nullptr;
+  //! declared after the renderer, goes first
+  std::unique_ptr<SbRenderThread> render_thread_ = nullptr;
   SbDimension dimension_ ;
   SDL_Color background_color_;  
   // bool new_size_ = false;
   bool is_fullscreen = false;
 };
 
-void sdl_init();
+/*! With headless = true SDL uses the dummy video driver, windows are hidden and render through the software renderer, so that a game runs without a display, e.g. for the benchmarks.
+ */
+void sdl_init(bool headless = false);
+bool sdl_headless();
 void sdl_quit();
 
 